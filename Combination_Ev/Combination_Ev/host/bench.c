@@ -0,0 +1,617 @@
+/*
+ * bench.c - Passenger traffic benchmark
+ * Drives the unmodified firmware (main.c built as ev_main()) on the host HAL
+ * backend with generated passengers that press hall buttons, board when their
+ * call is answered, press their destination and the door close button, and
+ * alight at the destination. Only buttons and LEDs are used, so whichever
+ * dispatch policy is compiled into main.c is what gets measured.
+ * Each scenario runs in its own process (the firmware never returns) with a
+ * seeded generator, so results are reproducible and comparable to a baseline.
+ *
+ *   bench [-s seed] [-l pax_per_min] [-m minutes] [-o results] [-b baseline] [-x percent] [scenario ...]
+ *     scenario: up-peak | down-peak | inter-floor | random (default: all)
+ */
+
+#include "building.h"
+#include "pinmacro.h"
+#include "sim.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// =================================================================================
+// --- 상수 정의 ---
+// =================================================================================
+#define BENCH_MAX_PAX 8192
+#define BENCH_QUEUE_SIZE 64
+#define BENCH_START_MS 2000UL       // 첫 승객 도착 (영점 조정이 끝난 뒤)
+#define BENCH_PRESS_MS 60           // 버튼을 누르고 있는 시간 (디바운스 20ms보다 길게)
+#define BENCH_PRESS_GAP_MS 40       // 다음 버튼까지 간격
+#define BENCH_SETTLE_MS 200         // 누른 뒤 호출이 등록되었다고 보는 시간 (LED가 켜지지 않고 바로 처리된 경우)
+#define BENCH_REPRESS_MS 5000       // 호출 LED가 꺼진 뒤 이 시간 안에 문이 열리지 않으면 다시 누름
+#define BENCH_DWELL_MS 1000         // 마지막 승객이 타고 내린 뒤 닫힘 버튼까지 (문 열림 유지 50초 대신)
+#define BENCH_DRAIN_MS (20 * 60000UL) // 도착이 끝난 뒤 남은 승객을 처리할 최대 시간
+#define BENCH_DEFAULT_RATE 1.5      // 건물 전체 승객 도착률 (명/분)
+#define BENCH_DEFAULT_MINUTES 60    // 승객 도착 시간
+#define BENCH_DEFAULT_TOLERANCE 5.0 // 기준 대비 허용 악화 (%)
+
+#define HALF_STEPS_PER_FLOOR (2L * STEPS_PER_FLOOR)
+
+enum
+{
+  PAX_WAITING,
+  PAX_RIDING,
+  PAX_DONE
+};
+
+enum
+{
+  SCN_UP_PEAK,
+  SCN_DOWN_PEAK,
+  SCN_INTER_FLOOR,
+  SCN_RANDOM,
+  SCN_COUNT
+};
+
+typedef struct
+{
+  uint32_t arrive_ms;
+  uint32_t board_ms;
+  uint32_t alight_ms;
+  uint8_t origin;
+  uint8_t dest;
+  uint8_t state;
+  uint8_t registered; // 홀 호출이 등록된 것을 확인함
+  uint32_t lost_ms;   // 내 호출 LED가 꺼진 채 문이 열리지 않은 시작 시각 (0 = 아님)
+} pax_t;
+
+typedef struct
+{
+  uint32_t arrived;
+  uint32_t delivered;
+  double wait_avg;    // 도착 -> 탑승 (s)
+  double wait_p95;
+  double journey_avg; // 도착 -> 하차 (s)
+  double journey_p95;
+  double calls_per_hour; // 꺼진 호출 LED (카 + 홀)
+  double pax_per_hour;   // 처리 용량 (하차 승객)
+  double steps;          // 이동 거리 (Full Step)
+  double door_cycles;
+} result_t;
+
+typedef struct
+{
+  const char *name;
+  size_t offset;
+  int8_t better; // -1: 작을수록 좋음, 1: 클수록 좋음
+} metric_t;
+
+static const char *scenario_names[SCN_COUNT] = {"up-peak", "down-peak", "inter-floor", "random"};
+
+static const metric_t metrics[] = {
+    {"wait_avg_s", offsetof(result_t, wait_avg), -1},
+    {"wait_p95_s", offsetof(result_t, wait_p95), -1},
+    {"journey_avg_s", offsetof(result_t, journey_avg), -1},
+    {"journey_p95_s", offsetof(result_t, journey_p95), -1},
+    {"calls_per_h", offsetof(result_t, calls_per_hour), 1},
+    {"pax_per_h", offsetof(result_t, pax_per_hour), 1},
+    {"steps", offsetof(result_t, steps), -1},
+    {"door_cycles", offsetof(result_t, door_cycles), -1},
+};
+
+// 펌웨어의 main() (Makefile에서 -Dmain=ev_main으로 컴파일)
+int ev_main(void);
+
+// =================================================================================
+// --- 전역 변수 (시나리오 프로세스마다 따로) ---
+// =================================================================================
+static uint8_t scenario;
+static uint32_t seed = 1;
+static double rate_per_min = BENCH_DEFAULT_RATE;
+static uint32_t window_ms = BENCH_DEFAULT_MINUTES * 60000UL;
+static int result_fd = -1;
+
+static uint32_t rng_state;
+static double floor_weight[FLOOR_COUNT + 1];
+static double next_arrival[FLOOR_COUNT + 1];
+
+static pax_t pax[BENCH_MAX_PAX];
+static uint32_t pax_count = 0;
+static uint32_t first_active = 0;
+
+static uint8_t queue[BENCH_QUEUE_SIZE];
+static uint8_t queue_head = 0;
+static uint8_t queue_tail = 0;
+static int16_t held_bit = -1;
+static uint32_t release_ms = 0;
+static uint32_t next_press_ms = 0;
+static uint32_t last_press_ms[SW_COUNT];
+
+static uint8_t door_was_open = 0;
+static uint8_t close_pressed = 0;
+static uint32_t last_move_ms = 0;
+static uint32_t door_cycles = 0;
+static uint8_t led_was_lit[LED_COUNT];
+static uint32_t calls_served = 0;
+
+// =================================================================================
+// --- 교통량 생성 ---
+// =================================================================================
+
+static double uniform(void)
+{
+  // xorshift32 (libc와 무관하게 같은 시드면 같은 승객)
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return (rng_state >> 8) / 16777216.0;
+}
+
+static double exp_interval_ms(double per_min)
+{
+  return -log(1.0 - uniform()) * 60000.0 / per_min;
+}
+
+static uint8_t other_floor(uint8_t origin, uint8_t lowest)
+{
+  uint8_t f;
+  do
+  {
+    f = lowest + (uint8_t)(uniform() * (FLOOR_COUNT - lowest + 1));
+  } while (f == origin);
+  return f;
+}
+
+// 출발 층마다 독립 포아송 도착 (도착률 = 전체 도착률 x 층 가중치)
+static void traffic_init(void)
+{
+  rng_state = seed * 2654435761UL + scenario * 40503UL + 1;
+  if (!rng_state) rng_state = 1;
+
+  double total = 0;
+  for (uint8_t f = 1; f <= FLOOR_COUNT; f++)
+  {
+    switch (scenario)
+    {
+    case SCN_UP_PEAK: // 출근: 대부분 1층에서 위로
+      floor_weight[f] = (f == 1) ? 0.85 : 0.15 / (FLOOR_COUNT - 1);
+      break;
+    case SCN_DOWN_PEAK: // 퇴근: 대부분 위층에서 1층으로
+      floor_weight[f] = (f == 1) ? 0.05 : 0.95 / (FLOOR_COUNT - 1);
+      break;
+    case SCN_INTER_FLOOR: // 층간: 1층을 제외한 층 사이
+      floor_weight[f] = (f == 1) ? 0 : 1.0 / (FLOOR_COUNT - 1);
+      break;
+    default: // 랜덤: 층마다 다른 도착률
+      floor_weight[f] = 0.25 + uniform();
+      break;
+    }
+    total += floor_weight[f];
+  }
+
+  for (uint8_t f = 1; f <= FLOOR_COUNT; f++)
+  {
+    floor_weight[f] /= total;
+    next_arrival[f] = BENCH_START_MS + (floor_weight[f] > 0 ? exp_interval_ms(rate_per_min * floor_weight[f]) : 1e18);
+  }
+}
+
+static uint8_t pick_dest(uint8_t origin)
+{
+  switch (scenario)
+  {
+  case SCN_UP_PEAK:
+    return other_floor(origin, 1);
+  case SCN_DOWN_PEAK:
+    return (origin != 1 && uniform() < 0.85) ? 1 : other_floor(origin, 1);
+  case SCN_INTER_FLOOR:
+    return other_floor(origin, 2);
+  default:
+    return other_floor(origin, 1);
+  }
+}
+
+// =================================================================================
+// --- 버튼 입력 (한 번에 하나씩) ---
+// =================================================================================
+
+static void queue_press(uint8_t bit)
+{
+  for (uint8_t i = queue_tail; i != queue_head; i = (i + 1) % BENCH_QUEUE_SIZE)
+  {
+    if (queue[i] == bit) return; // 이미 누를 예정
+  }
+  if (held_bit == bit) return;
+
+  uint8_t next = (queue_head + 1) % BENCH_QUEUE_SIZE;
+  if (next == queue_tail) return; // 가득 참: 다시 누르기 규칙이 나중에 처리
+  queue[queue_head] = bit;
+  queue_head = next;
+}
+
+static void buttons_poll(uint32_t now_ms)
+{
+  if (held_bit >= 0 && now_ms >= release_ms)
+  {
+    sim_switch((uint8_t)held_bit, 0);
+    held_bit = -1;
+    next_press_ms = now_ms + BENCH_PRESS_GAP_MS;
+  }
+
+  if (held_bit < 0 && queue_tail != queue_head && now_ms >= next_press_ms)
+  {
+    held_bit = queue[queue_tail];
+    queue_tail = (queue_tail + 1) % BENCH_QUEUE_SIZE;
+    sim_switch((uint8_t)held_bit, 1);
+    release_ms = now_ms + BENCH_PRESS_MS;
+    last_press_ms[held_bit] = now_ms;
+  }
+}
+
+// =================================================================================
+// --- 승객 ---
+// =================================================================================
+
+static uint8_t hall_index(const pax_t *p)
+{
+  return building_hall_index(p->origin, p->dest > p->origin ? DIR_ASCENDING : DIR_DESCENDING);
+}
+
+static void spawn(uint8_t origin, uint32_t now_ms)
+{
+  if (pax_count >= BENCH_MAX_PAX) return;
+
+  pax_t *p = &pax[pax_count++];
+  p->arrive_ms = now_ms;
+  p->origin = origin;
+  p->dest = pick_dest(origin);
+  p->state = PAX_WAITING;
+  p->registered = 0;
+  p->lost_ms = 0;
+
+  uint8_t index = hall_index(p);
+  if (!sim_led(LED_CALL_BIT(index))) queue_press(SW_CALL_BIT(index));
+}
+
+static void passengers_poll(uint32_t now_ms, uint8_t door_floor)
+{
+  while (first_active < pax_count && pax[first_active].state == PAX_DONE) first_active++;
+
+  for (uint32_t i = first_active; i < pax_count; i++)
+  {
+    pax_t *p = &pax[i];
+
+    if (p->state == PAX_WAITING)
+    {
+      uint8_t index = hall_index(p);
+      uint8_t sw = SW_CALL_BIT(index);
+      uint8_t lit = sim_led(LED_CALL_BIT(index));
+
+      // 호출 LED가 켜진 것을 봤거나, 누른 뒤 LED가 켜지기 전에 바로 처리된 경우
+      if (!p->registered &&
+          (lit || (last_press_ms[sw] >= p->arrive_ms && now_ms - last_press_ms[sw] >= BENCH_SETTLE_MS)))
+      {
+        p->registered = 1;
+      }
+
+      if (p->registered && !lit && door_floor == p->origin)
+      {
+        // 내 방향 호출이 처리되어 문이 열림 -> 탑승 후 목적층 버튼
+        p->state = PAX_RIDING;
+        p->board_ms = now_ms;
+        p->lost_ms = 0;
+        last_move_ms = now_ms;
+        if (!sim_led(LED_CAR_FLOOR_BIT(p->dest))) queue_press(SW_CAR_FLOOR_BIT(p->dest));
+      }
+      else if (lit || door_floor == p->origin)
+      {
+        p->lost_ms = 0;
+      }
+      else if (!p->lost_ms)
+      {
+        p->lost_ms = now_ms; // 도착해서 문을 여는 중일 수 있으므로 잠시 기다림
+      }
+      else if (now_ms - p->lost_ms >= BENCH_REPRESS_MS)
+      {
+        queue_press(sw);
+        p->lost_ms = 0;
+      }
+    }
+    else if (p->state == PAX_RIDING)
+    {
+      uint8_t sw = SW_CAR_FLOOR_BIT(p->dest);
+
+      if (door_floor == p->dest)
+      {
+        p->state = PAX_DONE;
+        p->alight_ms = now_ms;
+        last_move_ms = now_ms;
+      }
+      else if (sim_led(LED_CAR_FLOOR_BIT(p->dest)))
+      {
+        p->lost_ms = 0;
+      }
+      else if (!p->lost_ms)
+      {
+        p->lost_ms = now_ms;
+      }
+      else if (now_ms - p->lost_ms >= BENCH_REPRESS_MS)
+      {
+        queue_press(sw);
+        p->lost_ms = 0;
+      }
+    }
+  }
+}
+
+// =================================================================================
+// --- 결과 ---
+// =================================================================================
+
+static int by_value(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void stats(uint32_t *values, uint32_t n, double *avg, double *p95)
+{
+  *avg = *p95 = 0;
+  if (!n) return;
+
+  double sum = 0;
+  for (uint32_t i = 0; i < n; i++) sum += values[i];
+  qsort(values, n, sizeof(values[0]), by_value);
+
+  *avg = sum / n / 1000.0;
+  *p95 = values[(uint32_t)ceil(0.95 * n) - 1] / 1000.0;
+}
+
+static void finish(uint32_t now_ms)
+{
+  static uint32_t waits[BENCH_MAX_PAX], journeys[BENCH_MAX_PAX];
+  uint32_t boarded = 0;
+  result_t r;
+
+  memset(&r, 0, sizeof(r));
+  r.arrived = pax_count;
+
+  for (uint32_t i = 0; i < pax_count; i++)
+  {
+    if (pax[i].state != PAX_WAITING) waits[boarded++] = pax[i].board_ms - pax[i].arrive_ms;
+    if (pax[i].state == PAX_DONE) journeys[r.delivered++] = pax[i].alight_ms - pax[i].arrive_ms;
+  }
+
+  stats(waits, boarded, &r.wait_avg, &r.wait_p95);
+  stats(journeys, r.delivered, &r.journey_avg, &r.journey_p95);
+
+  double hours = (now_ms - BENCH_START_MS) / 3600000.0;
+  r.calls_per_hour = calls_served / hours;
+  r.pax_per_hour = r.delivered / hours;
+  r.steps = sim_car_travel() / 2;
+  r.door_cycles = door_cycles;
+
+  if (write(result_fd, &r, sizeof(r)) != sizeof(r)) _exit(1);
+  _exit(0);
+}
+
+void sim_poll(uint32_t now_ms)
+{
+  // 도착
+  for (uint8_t f = 1; f <= FLOOR_COUNT; f++)
+  {
+    while (now_ms < BENCH_START_MS + window_ms && next_arrival[f] <= now_ms)
+    {
+      spawn(f, now_ms);
+      next_arrival[f] += exp_interval_ms(rate_per_min * floor_weight[f]);
+    }
+  }
+
+  // 문이 다 열린 층 (0 = 없음)
+  int32_t pos = sim_car_position();
+  uint8_t door_floor = 0;
+  if (pos >= 0 && pos % HALF_STEPS_PER_FLOOR == 0 && sim_servo_pulse() >= SIM_DOOR_OPEN_US)
+  {
+    door_floor = (uint8_t)(pos / HALF_STEPS_PER_FLOOR + 1);
+  }
+
+  if (door_floor && !door_was_open)
+  {
+    door_cycles++;
+    close_pressed = 0;
+    last_move_ms = now_ms;
+  }
+  door_was_open = door_floor != 0;
+
+  passengers_poll(now_ms, door_floor);
+
+  // 타고 내리기가 끝나면 승객이 닫힘 버튼을 누름 (남은 승객이 있을 때만)
+  if (door_floor && !close_pressed && first_active < pax_count && now_ms - last_move_ms >= BENCH_DWELL_MS)
+  {
+    queue_press(SW_CAR_CLOSE_BIT);
+    close_pressed = 1;
+  }
+
+  buttons_poll(now_ms);
+
+  // 처리된 호출 = 켜져 있다 꺼진 카/홀 호출 LED
+  for (uint8_t f = 1; f <= FLOOR_COUNT; f++)
+  {
+    uint8_t bit = LED_CAR_FLOOR_BIT(f), lit = sim_led(bit);
+    if (led_was_lit[bit] && !lit) calls_served++;
+    led_was_lit[bit] = lit;
+  }
+  for (uint8_t i = 0; i < HALL_CALL_COUNT; i++)
+  {
+    uint8_t bit = LED_CALL_BIT(i), lit = sim_led(bit);
+    if (led_was_lit[bit] && !lit) calls_served++;
+    led_was_lit[bit] = lit;
+  }
+
+  uint32_t end_ms = BENCH_START_MS + window_ms;
+  if ((now_ms >= end_ms && first_active >= pax_count) || now_ms >= end_ms + BENCH_DRAIN_MS)
+  {
+    finish(now_ms);
+  }
+}
+
+// =================================================================================
+// --- 시나리오 실행과 기준 비교 ---
+// =================================================================================
+
+static int run_scenario(uint8_t index, result_t *r)
+{
+  int fds[2];
+  if (pipe(fds)) return -1;
+
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) return -1;
+
+  if (pid == 0)
+  {
+    close(fds[0]);
+    scenario = index;
+    result_fd = fds[1];
+    traffic_init();
+    ev_main();
+    _exit(1);
+  }
+
+  close(fds[1]);
+  ssize_t n = read(fds[0], r, sizeof(*r));
+  close(fds[0]);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return (n == sizeof(*r) && WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+}
+
+static double metric_value(const result_t *r, const metric_t *m)
+{
+  return *(const double *)((const char *)r + m->offset);
+}
+
+// 기준 파일의 같은 시나리오/지표와 비교, 악화된 지표 수를 반환
+static int compare(FILE *baseline, const char *name, const result_t *r, double tolerance)
+{
+  char scn[32], metric[32];
+  double base;
+  int worse = 0;
+
+  rewind(baseline);
+  while (fscanf(baseline, "%31s %31s %lf", scn, metric, &base) == 3)
+  {
+    if (strcmp(scn, name)) continue;
+
+    for (uint8_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++)
+    {
+      if (strcmp(metric, metrics[i].name)) continue;
+
+      double value = metric_value(r, &metrics[i]);
+      double delta = (value - base) * -metrics[i].better; // 양수 = 나빠짐
+      if (delta > fabs(base) * tolerance / 100.0 + 1e-9)
+      {
+        printf("REGRESSION %s %s: %.2f -> %.2f\n", name, metric, base, value);
+        worse++;
+      }
+    }
+  }
+  return worse;
+}
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "usage: bench [-s seed] [-l pax_per_min] [-m minutes] [-o results] [-b baseline] [-x percent] [scenario ...]\n"
+          "  scenario: up-peak | down-peak | inter-floor | random (default: all)\n");
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  const char *out_path = NULL, *base_path = NULL;
+  double tolerance = BENCH_DEFAULT_TOLERANCE;
+  uint8_t selected[SCN_COUNT] = {0};
+  uint8_t any = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "-s") && i + 1 < argc)
+      seed = (uint32_t)strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "-l") && i + 1 < argc)
+      rate_per_min = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+      window_ms = (uint32_t)(atof(argv[++i]) * 60000);
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+      out_path = argv[++i];
+    else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+      base_path = argv[++i];
+    else if (!strcmp(argv[i], "-x") && i + 1 < argc)
+      tolerance = atof(argv[++i]);
+    else
+    {
+      uint8_t k = 0;
+      while (k < SCN_COUNT && strcmp(argv[i], scenario_names[k])) k++;
+      if (k == SCN_COUNT) usage();
+      selected[k] = any = 1;
+    }
+  }
+  if (rate_per_min <= 0 || !window_ms) usage();
+
+  FILE *out = out_path ? fopen(out_path, "w") : NULL;
+  FILE *baseline = base_path ? fopen(base_path, "r") : NULL;
+  if ((out_path && !out) || (base_path && !baseline))
+  {
+    perror("bench");
+    return 2;
+  }
+
+  printf("seed %lu, %.2f pax/min, %lu min, %u floors\n", (unsigned long)seed, rate_per_min,
+         (unsigned long)(window_ms / 60000), FLOOR_COUNT);
+  printf("%-12s %6s %6s %9s %9s %9s %9s %8s %8s %8s %6s\n", "scenario", "pax", "done", "wait avg", "wait p95",
+         "jrny avg", "jrny p95", "calls/h", "pax/h", "steps", "doors");
+
+  int regressions = 0;
+  for (uint8_t k = 0; k < SCN_COUNT; k++)
+  {
+    if (any && !selected[k]) continue;
+
+    result_t r;
+    if (run_scenario(k, &r))
+    {
+      printf("%-12s failed\n", scenario_names[k]);
+      regressions++;
+      continue;
+    }
+
+    printf("%-12s %6lu %6lu %8.1fs %8.1fs %8.1fs %8.1fs %8.1f %8.1f %8.0f %6.0f\n", scenario_names[k],
+           (unsigned long)r.arrived, (unsigned long)r.delivered, r.wait_avg, r.wait_p95, r.journey_avg, r.journey_p95,
+           r.calls_per_hour, r.pax_per_hour, r.steps, r.door_cycles);
+
+    if (out)
+    {
+      for (uint8_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++)
+      {
+        fprintf(out, "%s %s %.3f\n", scenario_names[k], metrics[i].name, metric_value(&r, &metrics[i]));
+      }
+    }
+
+    if (baseline) regressions += compare(baseline, scenario_names[k], &r, tolerance);
+    if (r.delivered < r.arrived)
+    {
+      printf("UNSERVED %s: %lu of %lu passengers\n", scenario_names[k], (unsigned long)(r.arrived - r.delivered),
+             (unsigned long)r.arrived);
+      regressions++;
+    }
+  }
+
+  if (out) fclose(out);
+  if (baseline) fclose(baseline);
+  return regressions ? 1 : 0;
+}
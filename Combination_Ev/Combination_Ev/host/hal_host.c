@@ -0,0 +1,615 @@
+/*
+ * hal_host.c - Host (Linux) backend of the hardware abstraction layer
+ * Runs the unmodified firmware against a discrete-event model of the board:
+ * simulated time only moves inside hal_idle()/hal_delay_*(), and the timer,
+ * pin change and UART "interrupts" are delivered there in AVR vector order.
+ * The model tracks the car position from the stepper coil phases, drives the
+ * home switch from it, and simulates the servo, HX711, both shift register chains
+ * and the RS-485 bus shared with the peer car model in peer.c.
+ */
+
+#include "hal.h"
+#include "ic165.h"
+#include "ic595.h"
+#include "hx711.h"
+#include "sim.h"
+
+// =================================================================================
+// --- 상수 정의 ---
+// =================================================================================
+#define TICK_US 1000UL                                 // 시스템 틱 (1ms)
+#define STEP_TICK_US (1000000UL / HAL_STEP_TIMER_HZ)   // 스텝 타이머 1틱 (64us)
+#define SERVO_PERIOD_US 20000UL                        // 서보 PWM 주기 (50Hz)
+#define HX711_PERIOD_US 100000UL                       // HX711 변환 주기 (10 SPS)
+#define HX711_ZERO_RAW 142600L                         // 빈 카의 raw 값 (hx711.c의 초기 g_offset과 같음)
+#define HX711_NOISE 16                                 // raw 잡음 폭 (+-)
+#define SPI_BYTE_US 1                                  // SPI 1바이트 (8MHz)
+#define BUS_RX_QUEUE 64                                // 다른 카가 버스에 올린 바이트 대기열
+#define UART_RX_FIFO 2                                 // 수신 버퍼 (UDR0 2단, 넘치면 DOR0)
+#define NEVER UINT64_MAX
+
+// 코일 패턴 -> 자기장 위상 (Half Step 단위, 0xFF = 정지 토크 없음)
+// 회전자는 위상 차이만큼(-4 ~ +3) 따라가며, 스텝 시퀀스의 증가 방향이 위치 증가 방향
+static const uint8_t coil_phase[16] = {
+    [0b1001] = 0, [0b0001] = 1, [0b0011] = 2, [0b0010] = 3,
+    [0b0110] = 4, [0b0100] = 5, [0b1100] = 6, [0b1000] = 7,
+    [0b0000] = 0xFF, [0b0101] = 0xFF, [0b0111] = 0xFF, [0b1010] = 0xFF,
+    [0b1011] = 0xFF, [0b1101] = 0xFF, [0b1110] = 0xFF, [0b1111] = 0xFF};
+
+// =================================================================================
+// --- 모델 상태 ---
+// =================================================================================
+static uint64_t now_us = 0;
+static uint8_t irq_on = 0; // SREG I 비트
+static uint8_t in_isr = 0; // 처리 함수 실행 중 (중첩 인터럽트 없음)
+
+// 인터럽트 플래그
+static uint8_t tick_pending = 0;
+static uint8_t step_pending = 0;
+static uint8_t servo_pending = 0;
+static uint8_t pcint_pending = 0;
+
+// 1ms 틱
+static uint64_t tick_next = NEVER;
+
+// 스텝 타이머와 모터
+static uint64_t step_next = NEVER;
+static uint64_t step_last = 0;
+static uint64_t step_period = 0;
+static uint8_t rotor_phase = 0;
+static int32_t car_position = 0; // Half Step, 1층 = 0 (홈 스위치 위치)
+static uint32_t car_travel = 0;  // 누적 이동 거리 (Half Step)
+
+// 서보
+static uint64_t servo_next = NEVER;
+static uint8_t servo_irq = 0;
+static uint16_t servo_pulse = 0;
+
+// 입력 핀
+static uint8_t inputs = HAL_IN_HX711_DT | HAL_IN_HOME | HAL_IN_DOOR_CLOSED;
+static uint8_t pcint_mask = 0; // 핀 변화 인터럽트를 허용한 입력 (HAL_IN_*)
+static uint8_t obstacle = 0;
+
+// HX711
+static uint64_t hx_next = NEVER;
+static uint8_t hx_dt = 1;
+static uint8_t hx_sck = 0;
+static uint8_t hx_ready = 0; // 변환 완료, 읽기 전
+static uint8_t hx_bits = 0;  // 이번 읽기에서 내보낸 비트 수
+static long hx_value = 0;
+static int32_t load_g = 0;
+static uint32_t noise_seed = 1;
+
+// 74HC595 / 74HC165 체인 (stage[0] = MCU 쪽 첫 번째 칩)
+static uint8_t stage595[IC595_CHAIN_BYTES];
+static uint8_t latch595[IC595_CHAIN_BYTES] = {[0 ... IC595_CHAIN_BYTES - 1] = 0xFF}; // Active Low: 모두 꺼짐
+static uint8_t rclk = 1;
+static uint8_t stage165[IC165_CHAIN_BYTES];
+static uint8_t switches[IC165_CHAIN_BYTES]; // 1 = 눌림
+
+// UART 송신 (시프트 레지스터 + UDR0)
+static uint32_t uart_byte_us = 0;
+static uint8_t uart_tx_irq = HAL_UART_TX_IRQ_OFF;
+static uint8_t udr_full = 0;
+static uint8_t udr_byte = 0;
+static uint8_t shift_byte = 0;
+static uint8_t txc_flag = 0;
+static uint64_t shift_end = NEVER;
+static uint32_t uart_bytes = 0;
+static uint8_t rs485_de = 0;
+
+// UART 수신 (다른 카가 버스에 올린 바이트)
+static uint8_t bus_queue[BUS_RX_QUEUE];
+static uint8_t bus_head = 0;
+static uint8_t bus_count = 0;
+static uint64_t bus_end = NEVER; // 버스 위 바이트의 마지막 비트 시각
+static uint8_t rx_fifo[UART_RX_FIFO];
+static uint8_t rx_count = 0;
+static uint8_t rx_overrun = 0;
+static uint32_t bus_collisions = 0;
+static uint32_t rx_overruns = 0;
+
+// =================================================================================
+// --- 인터럽트 전달과 시간 진행 ---
+// =================================================================================
+
+static void set_inputs(uint8_t level)
+{
+  if ((inputs ^ level) & pcint_mask)
+  {
+    pcint_pending = 1;
+  }
+  inputs = level;
+}
+
+static void update_inputs(void)
+{
+  uint8_t level = HAL_IN_HOME | HAL_IN_DOOR_CLOSED;
+  if (hx_dt) level |= HAL_IN_HX711_DT;
+  if (car_position <= 0) level &= ~HAL_IN_HOME; // 1층에서 홈 스위치 눌림
+  if (obstacle) level &= ~HAL_IN_DOOR_CLOSED;
+  set_inputs(level);
+}
+
+// 허용된 인터럽트를 AVR 벡터 번호 순서(우선순위)로 하나씩 처리
+static void service(void)
+{
+  if (in_isr) return;
+
+  while (irq_on)
+  {
+    in_isr = 1;
+    irq_on = 0; // ISR 진입 시 I 비트 해제
+
+    if (pcint_pending)
+    {
+      pcint_pending = 0;
+      isr_on_pin_change(inputs);
+    }
+    else if (step_pending)
+    {
+      step_pending = 0;
+      stepper_on_timer();
+    }
+    else if (servo_pending)
+    {
+      servo_pending = 0;
+      servo_on_period();
+    }
+    else if (tick_pending)
+    {
+      tick_pending = 0;
+      sched_tick();
+    }
+    else if (rx_count)
+    {
+      uint8_t data = rx_fifo[0];
+      uint8_t overrun = rx_overrun;
+      rx_fifo[0] = rx_fifo[1];
+      rx_count--;
+      rx_overrun = 0;
+      uart_on_rx(data, overrun);
+    }
+    else if (uart_tx_irq == HAL_UART_TX_IRQ_READY && !udr_full)
+    {
+      uart_on_tx_ready();
+    }
+    else if (uart_tx_irq == HAL_UART_TX_IRQ_DONE && txc_flag)
+    {
+      txc_flag = 0;
+      uart_on_tx_done();
+    }
+    else
+    {
+      in_isr = 0;
+      irq_on = 1;
+      break;
+    }
+
+    in_isr = 0;
+    irq_on = 1; // RETI
+  }
+}
+
+static uint64_t next_event(void)
+{
+  uint64_t t = tick_next;
+  if (step_next < t) t = step_next;
+  if (servo_next < t) t = servo_next;
+  if (hx_next < t) t = hx_next;
+  if (shift_end < t) t = shift_end;
+  if (bus_end < t) t = bus_end;
+  return t;
+}
+
+static long hx711_sample(void)
+{
+  noise_seed = noise_seed * 1103515245UL + 12345UL;
+  long noise = (long)((noise_seed >> 16) % (2 * HX711_NOISE + 1)) - HX711_NOISE;
+  return HX711_ZERO_RAW + (long)(((int64_t)load_g * LOADCELL_SCALE_Q16) >> 16) + noise;
+}
+
+// 현재 시각(now_us)에 도달한 하드웨어 이벤트 처리
+static void fire_due(void)
+{
+  if (tick_next <= now_us)
+  {
+    tick_next += TICK_US;
+    sim_poll((uint32_t)(now_us / 1000));
+    tick_pending = 1;
+  }
+
+  if (step_next <= now_us)
+  {
+    // CTC: 비교 일치 후 카운터가 0부터 다시 셈 (ISR에서 주기를 바꾸면 바로 다음 스텝에 적용)
+    step_last = step_next;
+    step_next = step_last + step_period;
+    step_pending = 1;
+  }
+
+  if (servo_next <= now_us)
+  {
+    servo_next += SERVO_PERIOD_US;
+    if (servo_irq) servo_pending = 1;
+  }
+
+  if (hx_next <= now_us)
+  {
+    hx_next += HX711_PERIOD_US;
+
+    // 읽는 도중에는 출력 레지스터가 바뀌지 않음
+    if (hx_bits == 0)
+    {
+      hx_value = hx711_sample() & 0xFFFFFFL;
+      hx_ready = 1;
+      hx_dt = 0;
+      update_inputs();
+    }
+  }
+
+  if (shift_end <= now_us)
+  {
+    uart_bytes++;
+    if (rs485_de) peer_on_bus_byte(shift_byte); // DE가 꺼져 있으면 버스에 나가지 않음
+    if (udr_full)
+    {
+      udr_full = 0;
+      shift_byte = udr_byte;
+      shift_end = now_us + uart_byte_us;
+    }
+    else
+    {
+      shift_end = NEVER;
+      txc_flag = 1;
+    }
+  }
+
+  if (bus_end <= now_us)
+  {
+    uint8_t data = bus_queue[bus_head];
+    bus_head = (bus_head + 1) % BUS_RX_QUEUE;
+    bus_count--;
+    bus_end = bus_count ? now_us + uart_byte_us : NEVER;
+
+    // 3번째 바이트가 들어올 때까지 읽지 않으면 오버런 (이 바이트는 버려짐)
+    if (rx_count < UART_RX_FIFO)
+      rx_fifo[rx_count++] = data;
+    else
+    {
+      rx_overrun = 1;
+      rx_overruns++;
+    }
+  }
+}
+
+// target까지 시간을 진행하며 그 사이의 이벤트와 인터럽트를 처리
+static void advance(uint64_t target)
+{
+  for (;;)
+  {
+    service();
+
+    uint64_t t = next_event();
+    if (t > target) break;
+
+    now_us = t;
+    fire_due();
+  }
+
+  if (target > now_us) now_us = target;
+  service();
+}
+
+uint8_t hal_irq_save(void)
+{
+  uint8_t state = irq_on;
+  irq_on = 0;
+  return state;
+}
+
+void hal_irq_restore(const uint8_t *state)
+{
+  irq_on = *state;
+  service(); // 금지 구간에 걸려 있던 인터럽트
+}
+
+// =================================================================================
+// --- 시스템 ---
+// =================================================================================
+
+void hal_irq_enable(void)
+{
+  irq_on = 1;
+  service();
+}
+
+void hal_idle(void)
+{
+  if (!irq_on)
+  {
+    advance(now_us + TICK_US); // 인터럽트 금지 상태의 슬립: 깨울 방법이 없으므로 시간만 진행
+    return;
+  }
+
+  // 대기 중인 인터럽트는 허용되는 즉시 처리되므로, 다음 하드웨어 이벤트(최대 1ms 후 틱)까지 슬립
+  uint64_t t = next_event();
+  advance(t == NEVER ? now_us + TICK_US : t);
+}
+
+void hal_delay_us(uint16_t us)
+{
+  advance(now_us + us);
+}
+
+void hal_delay_ms(uint16_t ms)
+{
+  advance(now_us + (uint64_t)ms * 1000);
+}
+
+void hal_tick_init(void)
+{
+  tick_next = now_us + TICK_US;
+}
+
+// =================================================================================
+// --- 74HC595 / 74HC165 체인 ---
+// =================================================================================
+
+void hal_spi_init(void)
+{
+  rclk = 1;
+}
+
+uint8_t hal_spi_transfer(uint8_t data)
+{
+  // 공유 SCK로 두 체인이 동시에 한 바이트씩 시프트
+  uint8_t in = stage165[IC165_CHAIN_BYTES - 1];
+  for (uint8_t k = IC165_CHAIN_BYTES - 1; k > 0; k--) stage165[k] = stage165[k - 1];
+  stage165[0] = 0xFF;
+
+  for (uint8_t k = IC595_CHAIN_BYTES - 1; k > 0; k--) stage595[k] = stage595[k - 1];
+  stage595[0] = data;
+
+  advance(now_us + SPI_BYTE_US);
+  return in;
+}
+
+void hal_165_load(void)
+{
+  for (uint8_t k = 0; k < IC165_CHAIN_BYTES; k++) stage165[k] = ~switches[k]; // Active Low
+}
+
+void hal_595_latch(uint8_t level)
+{
+  if (level && !rclk)
+  {
+    for (uint8_t k = 0; k < IC595_CHAIN_BYTES; k++) latch595[k] = stage595[k];
+  }
+  rclk = level;
+}
+
+// =================================================================================
+// --- 입력 핀 ---
+// =================================================================================
+
+void hal_inputs_init(void)
+{
+  pcint_mask |= HAL_IN_HOME | HAL_IN_DOOR_CLOSED;
+  update_inputs();
+}
+
+uint8_t hal_inputs(void)
+{
+  return inputs;
+}
+
+// =================================================================================
+// --- HX711 ---
+// =================================================================================
+
+void hal_hx711_init(void)
+{
+  hx_sck = 0;
+  hx_next = now_us + HX711_PERIOD_US;
+}
+
+void hal_hx711_sck(uint8_t level)
+{
+  // 상승 에지마다 다음 비트를 DT로 내보냄, 25번째 펄스 후 다음 변환까지 DT HIGH
+  if (level && !hx_sck && hx_ready)
+  {
+    if (hx_bits < 24)
+    {
+      hx_dt = (hx_value >> (23 - hx_bits)) & 1;
+      hx_bits++;
+    }
+    else
+    {
+      hx_dt = 1;
+      hx_bits = 0;
+      hx_ready = 0;
+    }
+    update_inputs();
+  }
+  hx_sck = level;
+}
+
+void hal_hx711_irq(uint8_t enable)
+{
+  if (enable)
+    pcint_mask |= HAL_IN_HX711_DT;
+  else
+    pcint_mask &= ~HAL_IN_HX711_DT;
+}
+
+// =================================================================================
+// --- 스텝모터 ---
+// =================================================================================
+
+void hal_stepper_init(void)
+{
+  hal_step_timer_stop();
+}
+
+void hal_stepper_coils(uint8_t pattern)
+{
+  uint8_t phase = coil_phase[pattern & 0x0F];
+  if (phase == 0xFF) return;
+
+  int8_t delta = (int8_t)(((phase - rotor_phase + 4) & 0x07) - 4);
+  car_position += delta;
+  car_travel += (delta < 0) ? -delta : delta;
+  rotor_phase = phase;
+  update_inputs();
+}
+
+void hal_step_timer_start(uint8_t ticks)
+{
+  step_last = now_us;
+  step_period = (uint64_t)ticks * STEP_TICK_US;
+  step_next = now_us + step_period;
+}
+
+void hal_step_timer_period(uint8_t ticks)
+{
+  step_period = (uint64_t)ticks * STEP_TICK_US;
+  step_next = step_last + step_period;
+}
+
+void hal_step_timer_stop(void)
+{
+  step_next = NEVER;
+  step_pending = 0;
+}
+
+// =================================================================================
+// --- 서보 ---
+// =================================================================================
+
+void hal_servo_init(void)
+{
+  servo_next = now_us + SERVO_PERIOD_US;
+}
+
+void hal_servo_pulse(uint16_t us)
+{
+  servo_pulse = us;
+}
+
+void hal_servo_period_irq(uint8_t enable)
+{
+  servo_irq = enable;
+  if (!enable) servo_pending = 0;
+}
+
+// =================================================================================
+// --- UART / RS-485 ---
+// =================================================================================
+
+void hal_uart_init(uint32_t baudrate)
+{
+  uart_byte_us = (uint32_t)(10UL * 1000000UL / baudrate); // 8N1 = 10비트
+  if (uart_byte_us == 0) uart_byte_us = 1;
+}
+
+void hal_uart_write(uint8_t data)
+{
+  txc_flag = 0; // hal_avr.c와 같게 UDR0 쓰기 전에 TXC0을 지움 (DONE 전환 때는 지우지 않음)
+
+  if (shift_end == NEVER)
+  {
+    shift_byte = data;
+    shift_end = now_us + uart_byte_us; // 시프트 레지스터로 바로 이동
+  }
+  else
+  {
+    udr_byte = data;
+    udr_full = 1;
+  }
+}
+
+void hal_uart_tx_irq(uint8_t mode)
+{
+  uart_tx_irq = mode;
+}
+
+void hal_rs485_de(uint8_t enable)
+{
+  if (enable && bus_count) bus_collisions++; // 다른 카가 송신 중인데 버스를 잡음
+  rs485_de = enable;
+}
+
+// =================================================================================
+// --- 시나리오(sim.c)에서 사용하는 모델 접근 함수 ---
+// =================================================================================
+
+uint64_t sim_time_us(void)
+{
+  return now_us;
+}
+
+void sim_switch(uint8_t bit, uint8_t pressed)
+{
+  if (pressed)
+    switches[bit >> 3] |= (1 << (bit & 7));
+  else
+    switches[bit >> 3] &= ~(1 << (bit & 7));
+}
+
+void sim_obstacle(uint8_t blocked)
+{
+  obstacle = blocked;
+  update_inputs();
+}
+
+void sim_load_g(int32_t grams)
+{
+  load_g = grams;
+}
+
+uint8_t sim_led(uint8_t bit)
+{
+  return !(latch595[bit >> 3] & (1 << (bit & 7))); // Active Low
+}
+
+int32_t sim_car_position(void)
+{
+  return car_position;
+}
+
+uint32_t sim_car_travel(void)
+{
+  return car_travel;
+}
+
+uint16_t sim_servo_pulse(void)
+{
+  return servo_pulse;
+}
+
+uint32_t sim_uart_bytes(void)
+{
+  return uart_bytes;
+}
+
+void sim_bus_send(const uint8_t *data, uint8_t len)
+{
+  // 이 카가 DE를 잡고 있으면 두 송신기가 부딪힘 (TDMA 슬롯 위반 또는 DE 해제 실패)
+  if (rs485_de || shift_end != NEVER) bus_collisions++;
+
+  for (uint8_t i = 0; i < len && bus_count < BUS_RX_QUEUE; i++)
+  {
+    bus_queue[(bus_head + bus_count) % BUS_RX_QUEUE] = data[i];
+    if (bus_count++ == 0) bus_end = now_us + uart_byte_us;
+  }
+}
+
+uint32_t sim_bus_collisions(void)
+{
+  return bus_collisions;
+}
+
+uint32_t sim_uart_overruns(void)
+{
+  return rx_overruns;
+}
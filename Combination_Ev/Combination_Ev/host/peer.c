@@ -0,0 +1,220 @@
+/*
+ * peer.c - Second car on the RS-485 bus of the host simulation
+ * A protocol-level model of car 1: it answers every state broadcast of the car
+ * under test with its own state in its TDMA slot, acknowledges hall calls
+ * assigned to it and serves them after a fixed time (or at once, like a car
+ * idle at that floor). It can go silent (link failure) or ignore assignments
+ * (lost ASSIGN) so the handoff and takeover paths of the firmware can be
+ * exercised.
+ */
+
+#include "building.h"
+#include "eta.h"
+#include "link.h"
+#include "sim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// =================================================================================
+// --- 상수 정의 ---
+// =================================================================================
+#define PEER_ID 1
+#define PEER_SERVE_MS 3000 // 배정받은 호출을 처리(도착 + 문 열고 닫기)하는 데 걸리는 시간
+#define PEER_FRAME_MAX (LINK_MAX_PAYLOAD + 7)
+#define PEER_ACK_MAX 4 // 다음 슬롯에 보낼 ASSIGN_ACK 수
+
+// =================================================================================
+// --- 전역 변수 ---
+// =================================================================================
+static uint8_t active = 0;
+static uint8_t silent = 0;
+static uint8_t deaf = 0;
+static uint8_t quick = 0; // 1: 배정받은 호출을 그 자리에서 처리 (상태 방송에 나타나지 않음)
+static uint8_t floor_now = 1;
+static floor_mask_t up_calls = 0;
+static floor_mask_t down_calls = 0;
+static uint32_t serve_due_ms = 0; // 0 = 처리할 호출 없음
+static uint8_t tx_seq = 0;
+static uint64_t reply_due_us = 0; // 0 = 보낼 상태 없음
+static link_assign_t acks[PEER_ACK_MAX];
+static uint8_t ack_count = 0;
+
+// 버스 수신 (이 카가 보낸 프레임)
+static uint8_t rx[PEER_FRAME_MAX];
+static uint8_t rx_len = 0;
+static uint64_t rx_start_us = 0;
+
+static uint8_t crc8_update(uint8_t crc, uint8_t data)
+{
+  crc ^= data;
+  for (uint8_t i = 0; i < 8; i++) crc = (crc & 0x80) ? (crc << 1) ^ LINK_CRC_POLY : (crc << 1);
+  return crc;
+}
+
+static void send_frame(uint8_t dst, uint8_t type, const void *payload, uint8_t len)
+{
+  uint8_t frame[PEER_FRAME_MAX];
+  uint8_t crc = 0;
+
+  frame[0] = LINK_SYNC;
+  frame[1] = dst;
+  frame[2] = PEER_ID;
+  frame[3] = type;
+  frame[4] = tx_seq++;
+  frame[5] = len;
+  memcpy(&frame[6], payload, len);
+  for (uint8_t i = 1; i < 6 + len; i++) crc = crc8_update(crc, frame[i]);
+  frame[6 + len] = crc;
+
+  sim_bus_send(frame, len + 7);
+}
+
+static void send_state(void)
+{
+  car_state_t me;
+  memset(&me, 0, sizeof(me));
+
+  me.car_id = PEER_ID;
+  me.position = (int16_t)((floor_now - 1) * STEPS_PER_FLOOR);
+  me.floor = floor_now;
+  me.next_stop = floor_now;
+  me.state = ST_IDLE;
+  me.motion_dir = DIR_IDLE;
+  me.travel_dir = DIR_IDLE;
+  me.up_calls = up_calls;
+  me.down_calls = down_calls;
+  me.floor_ms = ETA_FLOOR_MS_INIT;
+
+  send_frame(LINK_BROADCAST, LINK_MSG_STATE, &me, sizeof(me));
+}
+
+static void on_frame(void)
+{
+  uint8_t len = rx[5];
+  uint8_t crc = 0;
+
+  for (uint8_t i = 1; i < 6 + len; i++) crc = crc8_update(crc, rx[i]);
+  if (crc != rx[6 + len]) return;
+
+  // 카 0의 상태 방송: 그 프레임 시작 + 슬롯 간격 뒤에 자기 상태로 응답 (카 0이 TDMA 기준)
+  if (rx[3] == LINK_MSG_STATE && rx[2] == 0)
+  {
+    reply_due_us = rx_start_us + PEER_ID * LINK_SLOT_MS * 1000UL;
+  }
+
+  // 이 카에 배정된 홀 호출
+  if (rx[3] == LINK_MSG_ASSIGN && rx[1] == PEER_ID && len == sizeof(link_assign_t) && !deaf)
+  {
+    link_assign_t assign;
+    memcpy(&assign, &rx[6], sizeof(assign));
+    if (ack_count < PEER_ACK_MAX) acks[ack_count++] = assign;
+
+    if (quick)
+    {
+      // 그 층에 서 있던 카처럼 바로 처리 (다음 상태 방송에는 호출이 없음)
+      floor_now = assign.floor;
+      return;
+    }
+    if (assign.dir == DIR_ASCENDING)
+      up_calls |= FLOOR_BIT(assign.floor);
+    else
+      down_calls |= FLOOR_BIT(assign.floor);
+    if (!serve_due_ms) serve_due_ms = (uint32_t)(sim_time_us() / 1000) + PEER_SERVE_MS;
+  }
+}
+
+// =================================================================================
+// --- sim.h 인터페이스 ---
+// =================================================================================
+
+void peer_on_bus_byte(uint8_t byte)
+{
+  if (!active) return;
+
+  if (rx_len == 0)
+  {
+    if (byte != LINK_SYNC) return;
+    rx_start_us = sim_time_us();
+  }
+  rx[rx_len++] = byte;
+
+  // SYNC DST SRC TYPE SEQ LEN payload CRC
+  if (rx_len == 6 && rx[5] > LINK_MAX_PAYLOAD)
+  {
+    rx_len = 0;
+    return;
+  }
+  if (rx_len >= 7 && rx_len == 7 + rx[5])
+  {
+    on_frame();
+    rx_len = 0;
+  }
+}
+
+void peer_start(uint8_t floor)
+{
+  active = 1;
+  floor_now = (floor >= 1 && floor <= FLOOR_COUNT) ? floor : 1;
+}
+
+void peer_silent(void)
+{
+  silent = 1;
+}
+
+void peer_deaf(void)
+{
+  deaf = 1;
+}
+
+void peer_quick(void)
+{
+  quick = 1;
+}
+
+void peer_poll(uint32_t now_ms)
+{
+  if (!active) return;
+
+  // 배정받은 호출 처리: 가장 낮은 호출 층으로 가서 그 층의 호출을 지움
+  if (serve_due_ms && now_ms >= serve_due_ms && !silent)
+  {
+    floor_mask_t calls = up_calls | down_calls;
+    for (uint8_t f = 1; f <= FLOOR_COUNT; f++)
+    {
+      if (!(calls & FLOOR_BIT(f))) continue;
+      floor_now = f;
+      up_calls &= ~FLOOR_BIT(f);
+      down_calls &= ~FLOOR_BIT(f);
+      break;
+    }
+    serve_due_ms = (up_calls | down_calls) ? now_ms + PEER_SERVE_MS : 0;
+  }
+
+  if (reply_due_us && now_ms * 1000ULL >= reply_due_us)
+  {
+    reply_due_us = 0;
+    if (!silent)
+    {
+      // 자기 슬롯에서 상태 다음에 밀린 ACK를 보냄
+      send_state();
+      for (uint8_t i = 0; i < ack_count; i++) send_frame(0, LINK_MSG_ASSIGN_ACK, &acks[i], sizeof(acks[i]));
+    }
+    ack_count = 0;
+  }
+}
+
+int peer_format(char *line, int size)
+{
+  if (!active) return 0;
+
+  int n = snprintf(line, size, "  peer %u%s [", floor_now, silent ? " silent" : "");
+  for (uint8_t f = 1; f <= FLOOR_COUNT && n < size; f++)
+  {
+    if (up_calls & FLOOR_BIT(f)) n += snprintf(line + n, size - n, "%u^", f);
+    if ((down_calls & FLOOR_BIT(f)) && n < size) n += snprintf(line + n, size - n, "%uv", f);
+  }
+  if (n < size) n += snprintf(line + n, size - n, "]");
+  return n;
+}
@@ -0,0 +1,339 @@
+/*
+ * sim.c - Host simulation driver
+ * Runs main.c (built as ev_main()) on the host HAL backend, replays a call
+ * scenario from the command line (or a seeded random one) and prints the
+ * car state every time it changes.
+ *
+ *   sim [-t seconds] [-r seed] [-q] [-e expect] [time:action ...]
+ *     action: carN | upN | dnN | open | close | bell | obstacle | load=GRAMS
+ *             peer=N (car 1 joins the bus at floor N) | peer-off | peer-deaf | peer-quick
+ *     expect: text the final state line must contain, e.g. "floor  4.00  door open"
+ *     e.g. sim -t 90 1:car4 5:dn2 30:up1
+ * Exits 1 if the expectation fails, the car ever moves with the door not closed,
+ * or (with a peer on the bus) frames collide or the UART overruns.
+ */
+
+#include "building.h"
+#include "pinmacro.h"
+#include "sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =================================================================================
+// --- 상수 정의 ---
+// =================================================================================
+#define SIM_MAX_ACTIONS 64
+#define SIM_DEFAULT_SECONDS 60
+#define SIM_PRESS_MS 100        // 버튼을 누르고 있는 시간 (디바운스 20ms보다 길게)
+#define SIM_OBSTACLE_MS 300     // 장애물 감지 스위치가 눌려 있는 시간
+#define SIM_SAMPLE_MS 10        // 상태 출력 주기
+#define SIM_RANDOM_MIN_MS 3000  // 랜덤 시나리오 호출 간격
+#define SIM_RANDOM_SPAN_MS 7000
+
+typedef struct
+{
+  uint32_t at_ms;
+  char what[16];
+} sim_action_t;
+
+// 펌웨어의 main() (Makefile에서 -Dmain=ev_main으로 컴파일)
+int ev_main(void);
+
+// =================================================================================
+// --- 전역 변수 ---
+// =================================================================================
+static sim_action_t actions[SIM_MAX_ACTIONS];
+static uint8_t action_count = 0;
+static uint8_t action_next = 0;
+
+static uint32_t limit_ms = SIM_DEFAULT_SECONDS * 1000UL;
+static uint8_t quiet = 0;
+static uint8_t random_mode = 0;
+static uint32_t random_next_ms = 0;
+
+static int16_t release_bit = -1; // 누르고 있는 스위치 (SW_*_BIT)
+static uint32_t release_ms = 0;
+static uint32_t obstacle_end_ms = 0;
+
+static char last_line[256];
+static uint32_t presses = 0;
+
+static const char *expect = NULL;    // 최종 상태에 포함되어야 할 문자열
+static int32_t last_position = 0;
+static uint8_t door_violation = 0;   // 문이 닫히지 않은 채 카가 움직임
+
+// =================================================================================
+// --- 시나리오 ---
+// =================================================================================
+
+static void press(uint8_t bit, uint32_t now_ms)
+{
+  if (release_bit >= 0) sim_switch((uint8_t)release_bit, 0);
+  sim_switch(bit, 1);
+  release_bit = bit;
+  release_ms = now_ms + SIM_PRESS_MS;
+  presses++;
+}
+
+static void hall_press(uint8_t floor, uint8_t dir, uint32_t now_ms)
+{
+  uint8_t index = building_hall_index(floor, dir);
+  if (index == HALL_CALL_NONE)
+  {
+    fprintf(stderr, "sim: no %s button at floor %u\n", dir == DIR_ASCENDING ? "up" : "down", floor);
+    return;
+  }
+  press(SW_CALL_BIT(index), now_ms);
+}
+
+static void run_action(const char *what, uint32_t now_ms)
+{
+  unsigned value = 0;
+
+  if (!quiet) printf("%9.3f  >> %s\n", now_ms / 1000.0, what);
+
+  if (sscanf(what, "car%u", &value) == 1 && value >= 1 && value <= FLOOR_COUNT)
+    press(SW_CAR_FLOOR_BIT(value), now_ms);
+  else if (sscanf(what, "up%u", &value) == 1 && value >= 1 && value <= FLOOR_COUNT)
+    hall_press(value, DIR_ASCENDING, now_ms);
+  else if (sscanf(what, "dn%u", &value) == 1 && value >= 1 && value <= FLOOR_COUNT)
+    hall_press(value, DIR_DESCENDING, now_ms);
+  else if (!strcmp(what, "open"))
+    press(SW_CAR_OPEN_BIT, now_ms);
+  else if (!strcmp(what, "close"))
+    press(SW_CAR_CLOSE_BIT, now_ms);
+  else if (!strcmp(what, "bell"))
+    press(SW_CAR_BELL_BIT, now_ms);
+  else if (!strcmp(what, "obstacle"))
+  {
+    sim_obstacle(1);
+    obstacle_end_ms = now_ms + SIM_OBSTACLE_MS;
+  }
+  else if (sscanf(what, "load=%u", &value) == 1)
+    sim_load_g((int32_t)value);
+  else if (sscanf(what, "peer=%u", &value) == 1 && value >= 1 && value <= FLOOR_COUNT)
+    peer_start((uint8_t)value);
+  else if (!strcmp(what, "peer-off"))
+    peer_silent();
+  else if (!strcmp(what, "peer-deaf"))
+    peer_deaf();
+  else if (!strcmp(what, "peer-quick"))
+    peer_quick();
+  else
+    fprintf(stderr, "sim: unknown action '%s'\n", what);
+}
+
+static void random_action(uint32_t now_ms)
+{
+  char what[16];
+  unsigned floor = 1 + rand() % FLOOR_COUNT;
+
+  switch (rand() % 3)
+  {
+  case 0:
+    snprintf(what, sizeof(what), "car%u", floor);
+    break;
+  case 1:
+    snprintf(what, sizeof(what), "%s%u", floor == FLOOR_COUNT ? "dn" : "up", floor);
+    break;
+  default:
+    snprintf(what, sizeof(what), "%s%u", floor == 1 ? "up" : "dn", floor);
+    break;
+  }
+
+  run_action(what, now_ms);
+}
+
+// =================================================================================
+// --- 상태 출력 ---
+// =================================================================================
+
+static void format_state(char *line, size_t size)
+{
+  int32_t pos = sim_car_position();
+  uint16_t pulse = sim_servo_pulse();
+  size_t n = 0;
+
+  // 위치는 1/4층 단위로 표시 (이동 중 출력량 제한)
+  int32_t quarter = (pos * 4 + (pos >= 0 ? STEPS_PER_FLOOR : -STEPS_PER_FLOOR)) / (2L * STEPS_PER_FLOOR);
+  n += snprintf(line + n, size - n, "floor %5.2f  door %-6s", 1 + quarter / 4.0,
+                pulse <= SIM_DOOR_CLOSED_US ? "closed" : pulse >= SIM_DOOR_OPEN_US ? "open" : "moving");
+
+  // FND: BCD 비트가 0이면 해당 출력 켜짐 (ic595_fndset())
+  uint8_t digit = (!sim_led(SEG_A_BIT)) | (!sim_led(SEG_B_BIT) << 1) |
+                  (!sim_led(SEG_C_BIT) << 2) | (!sim_led(SEG_D_BIT) << 3);
+  if (digit <= 9)
+    n += snprintf(line + n, size - n, "  fnd %u", digit);
+  else
+    n += snprintf(line + n, size - n, "  fnd -");
+
+  n += snprintf(line + n, size - n, "  car [");
+  for (uint8_t f = 1; f <= FLOOR_COUNT && n < size; f++)
+  {
+    if (sim_led(LED_CAR_FLOOR_BIT(f))) n += snprintf(line + n, size - n, "%u", f);
+  }
+
+  n += snprintf(line + n, size - n, "]  hall [");
+  for (uint8_t i = 0; i < HALL_CALL_COUNT && n < size; i++)
+  {
+    if (sim_led(LED_CALL_BIT(i)))
+      n += snprintf(line + n, size - n, "%u%c", building_hall_floor(i), building_hall_dir(i) == DIR_ASCENDING ? '^' : 'v');
+  }
+
+  n += snprintf(line + n, size - n, "]  lantern [");
+  for (uint8_t f = 1; f <= FLOOR_COUNT && n < size; f++)
+  {
+    if (sim_led(LED_LNT_BIT(f, DIR_ASCENDING))) n += snprintf(line + n, size - n, "%u^", f);
+    if (sim_led(LED_LNT_BIT(f, DIR_DESCENDING)) && n < size) n += snprintf(line + n, size - n, "%uv", f);
+  }
+
+  if (n < size) n += snprintf(line + n, size - n, "]");
+  if (n < size) peer_format(line + n, (int)(size - n));
+}
+
+static void finish(uint32_t now_ms)
+{
+  char line[sizeof(last_line)];
+  format_state(line, sizeof(line));
+
+  printf("%9.3f  end  %s\n", now_ms / 1000.0, line);
+  printf("sim: %u presses, %lu bus bytes\n", (unsigned)presses, (unsigned long)sim_uart_bytes());
+
+  int failed = door_violation;
+  if (sim_bus_collisions() || sim_uart_overruns())
+  {
+    printf("sim: FAIL %lu bus collisions, %lu UART overruns\n", (unsigned long)sim_bus_collisions(),
+           (unsigned long)sim_uart_overruns());
+    failed = 1;
+  }
+  if (expect && !strstr(line, expect))
+  {
+    printf("sim: FAIL expected \"%s\"\n", expect);
+    failed = 1;
+  }
+  exit(failed);
+}
+
+// 안전 조건: 카는 문이 닫혀 있을 때만 움직임
+static void check_door_interlock(uint32_t now_ms)
+{
+  int32_t pos = sim_car_position();
+
+  if (pos != last_position && sim_servo_pulse() > SIM_DOOR_CLOSED_US && !door_violation)
+  {
+    printf("%9.3f  FAIL car moving with door not closed\n", now_ms / 1000.0);
+    door_violation = 1;
+  }
+  last_position = pos;
+}
+
+void sim_poll(uint32_t now_ms)
+{
+  if (now_ms >= limit_ms) finish(now_ms);
+
+  check_door_interlock(now_ms);
+  peer_poll(now_ms);
+
+  if (release_bit >= 0 && now_ms >= release_ms)
+  {
+    sim_switch((uint8_t)release_bit, 0);
+    release_bit = -1;
+  }
+
+  if (obstacle_end_ms && now_ms >= obstacle_end_ms)
+  {
+    sim_obstacle(0);
+    obstacle_end_ms = 0;
+  }
+
+  while (action_next < action_count && now_ms >= actions[action_next].at_ms)
+  {
+    run_action(actions[action_next++].what, now_ms);
+  }
+
+  if (random_mode && now_ms >= random_next_ms)
+  {
+    random_action(now_ms);
+    random_next_ms = now_ms + SIM_RANDOM_MIN_MS + rand() % SIM_RANDOM_SPAN_MS;
+  }
+
+  if (!quiet && now_ms % SIM_SAMPLE_MS == 0)
+  {
+    char line[sizeof(last_line)];
+    format_state(line, sizeof(line));
+    if (strcmp(line, last_line))
+    {
+      printf("%9.3f  %s\n", now_ms / 1000.0, line);
+      strcpy(last_line, line);
+    }
+  }
+}
+
+// =================================================================================
+// --- 명령행 ---
+// =================================================================================
+
+static int by_time(const void *a, const void *b)
+{
+  const sim_action_t *x = a, *y = b;
+  return (x->at_ms > y->at_ms) - (x->at_ms < y->at_ms);
+}
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "usage: sim [-t seconds] [-r seed] [-q] [-e expect] [time:action ...]\n"
+          "  action: carN | upN | dnN | open | close | bell | obstacle | load=GRAMS\n"
+          "          peer=N | peer-off | peer-deaf | peer-quick\n");
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  static const char *demo[] = {"1:car3", "4:dn2", "11:close", "20:up1", "21:close"};
+
+  for (int i = 1; i < argc; i++)
+  {
+    double at;
+    char what[16];
+
+    if (!strcmp(argv[i], "-t") && i + 1 < argc)
+      limit_ms = (uint32_t)(atof(argv[++i]) * 1000);
+    else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+    {
+      srand((unsigned)atoi(argv[++i]));
+      random_mode = 1;
+      random_next_ms = 1000;
+    }
+    else if (!strcmp(argv[i], "-q"))
+      quiet = 1;
+    else if (!strcmp(argv[i], "-e") && i + 1 < argc)
+      expect = argv[++i];
+    else if (sscanf(argv[i], "%lf:%15s", &at, what) == 2 && at >= 0 && action_count < SIM_MAX_ACTIONS)
+    {
+      actions[action_count].at_ms = (uint32_t)(at * 1000);
+      strcpy(actions[action_count].what, what);
+      action_count++;
+    }
+    else
+      usage();
+  }
+
+  // 시나리오가 없으면 기본 데모 (카 호출, 이동 중 홀 호출, 닫힘 버튼, 1층 복귀)
+  if (!action_count && !random_mode)
+  {
+    for (uint8_t i = 0; i < sizeof(demo) / sizeof(demo[0]); i++)
+    {
+      unsigned at = 0;
+      sscanf(demo[i], "%u:%15s", &at, actions[i].what);
+      actions[i].at_ms = at * 1000UL;
+    }
+    action_count = sizeof(demo) / sizeof(demo[0]);
+  }
+
+  qsort(actions, action_count, sizeof(actions[0]), by_time);
+
+  return ev_main();
+}
@@ -0,0 +1,119 @@
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include <stdint.h>
+
+// =================================================================================
+// --- 호스트 시뮬레이션 ---
+// hal_host.c: HAL 호스트 백엔드 + 하드웨어 모델 (시간, 스텝모터, 서보, 스위치, HX711, 시프트 레지스터)
+// sim.c: 시나리오(호출 버튼 입력) 재생과 상태 출력
+// bench.c: 승객 교통량 벤치마크 (sim.c 대신 링크)
+// peer.c: RS-485 버스의 다른 카 (카 1) 모델
+// =================================================================================
+
+// 서보 펄스 폭으로 본 문 상태
+#define SIM_DOOR_CLOSED_US 550 // 이 펄스 폭 이하면 닫힘 (0도 = 500us)
+#define SIM_DOOR_OPEN_US 1400  // 이 펄스 폭 이상이면 열림 (90도 = 1450us)
+
+// 시뮬레이션 시간으로 1ms마다 (틱 인터럽트 직전) 호출됨 - sim.c / bench.c에서 구현
+void sim_poll(uint32_t now_ms);
+
+// 이 카가 RS-485 버스에 내보낸 바이트 (DE가 켜져 있을 때만) - peer.c에서 구현
+void peer_on_bus_byte(uint8_t byte);
+
+/**
+ * @brief 시뮬레이션 시간 (us)
+ */
+uint64_t sim_time_us(void);
+
+/**
+ * @brief 74HC165 체인의 스위치 누름/뗌 (비트 = SW_*_BIT)
+ */
+void sim_switch(uint8_t bit, uint8_t pressed);
+
+/**
+ * @brief 문 닫힘 스위치(장애물 감지) 입력
+ */
+void sim_obstacle(uint8_t blocked);
+
+/**
+ * @brief 카 안의 하중 (g)
+ */
+void sim_load_g(int32_t grams);
+
+/**
+ * @brief 74HC595 체인의 래치된 출력 (비트 = LED_*_BIT, 1 = 켜짐)
+ */
+uint8_t sim_led(uint8_t bit);
+
+/**
+ * @brief 코일 출력으로부터 추적한 카 위치 (Half Step, 1층 = 0)
+ */
+int32_t sim_car_position(void);
+
+/**
+ * @brief 누적 이동 거리 (Half Step, 방향 무관)
+ */
+uint32_t sim_car_travel(void);
+
+/**
+ * @brief 마지막 서보 펄스 폭 (us, 0 = 출력 없음)
+ */
+uint16_t sim_servo_pulse(void);
+
+/**
+ * @brief RS-485 버스로 나간 바이트 수
+ */
+uint32_t sim_uart_bytes(void);
+
+/**
+ * @brief 다른 카가 버스에 바이트를 올림 (보율에 맞춰 한 바이트씩 이 카의 UART로 수신)
+ */
+void sim_bus_send(const uint8_t *data, uint8_t len);
+
+/**
+ * @brief 이 카가 송신 중(DE)일 때 다른 카가 송신을 시작한 횟수
+ */
+uint32_t sim_bus_collisions(void);
+
+/**
+ * @brief UART 수신 오버런 횟수
+ */
+uint32_t sim_uart_overruns(void);
+
+// =================================================================================
+// --- 다른 카 (peer.c, 카 1을 프로토콜 수준으로 흉내냄) ---
+// =================================================================================
+
+/**
+ * @brief floor층에 멈춰 있는 카 1을 버스에 연결합니다. (이 카의 상태 방송마다 자기 슬롯에서 응답)
+ */
+void peer_start(uint8_t floor);
+
+/**
+ * @brief 카 1의 송신을 끊습니다. (링크 단절 -> 이 카가 호출 인수)
+ */
+void peer_silent(void);
+
+/**
+ * @brief 카 1이 배정(ASSIGN)을 무시합니다. (배정 손실 -> 이 카가 직접 처리)
+ */
+void peer_deaf(void);
+
+/**
+ * @brief 카 1이 배정받은 호출을 바로 처리합니다. (그 층에 서 있던 카처럼, 상태 방송에는 나타나지 않음)
+ */
+void peer_quick(void);
+
+/**
+ * @brief 1ms마다 호출 (sim_poll())
+ */
+void peer_poll(uint32_t now_ms);
+
+/**
+ * @brief 카 1 상태 요약 (비활성이면 0 반환)
+ * @return 출력한 길이
+ */
+int peer_format(char *line, int size);
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef _BUILDING_H_
+#define _BUILDING_H_
+
+#include "pinmacro.h"
+
+#include <stdint.h>
+
+// =================================================================================
+// --- 건물 구성 (컴파일 시 설정) ---
+// 층 수, 층간 스텝 수, 홀 버튼이 있는 층만 정하면 호출 비트맵 크기, 74595/74165 배치,
+// 카 간 상태 프레임의 호출 필드가 모두 여기서 만들어집니다.
+// 다른 건물용으로 빌드할 때는 -DFLOOR_COUNT=6 처럼 컴파일 옵션으로 바꿀 수 있습니다.
+// =================================================================================
+#ifndef FLOOR_COUNT
+#define FLOOR_COUNT 4 // 층 수 (1층 ~ FLOOR_COUNT층, 최대 16)
+#endif
+
+#ifndef STEPS_PER_FLOOR
+#define STEPS_PER_FLOOR 2000 // 층간 이동 스텝 수 (Full Step, 28BYJ-48 1회전, 1층 = 위치 0)
+#endif
+
+// 홀 호출 버튼이 있는 층 비트맵 (bit 0 = 1층), 기본값: 최상층 제외 상행, 1층 제외 하행
+#ifndef HALL_UP_FLOORS
+#define HALL_UP_FLOORS ((1UL << (FLOOR_COUNT - 1)) - 1)
+#endif
+#ifndef HALL_DOWN_FLOORS
+#define HALL_DOWN_FLOORS (((1UL << FLOOR_COUNT) - 1) & ~1UL)
+#endif
+
+#if FLOOR_COUNT < 2 || FLOOR_COUNT > 16
+#error "FLOOR_COUNT는 2 ~ 16층만 지원합니다"
+#endif
+#if (HALL_UP_FLOORS | HALL_DOWN_FLOORS) >= (1UL << FLOOR_COUNT)
+#error "HALL_UP_FLOORS / HALL_DOWN_FLOORS에 없는 층이 있습니다"
+#endif
+#if (FLOOR_COUNT - 1) * STEPS_PER_FLOOR > 32767
+#error "최상층 위치가 car_state_t.position(int16_t) 범위를 넘습니다"
+#endif
+
+// =================================================================================
+// --- 층 비트맵 ---
+// =================================================================================
+#if FLOOR_COUNT <= 8
+typedef uint8_t floor_mask_t;
+#else
+typedef uint16_t floor_mask_t;
+#endif
+
+#define FLOOR_BIT(floor) ((floor_mask_t)(1U << ((floor) - 1)))
+#define FLOORS_ALL ((floor_mask_t)((1UL << FLOOR_COUNT) - 1))
+#define FLOORS_BELOW(floor) ((floor_mask_t)(FLOOR_BIT(floor) - 1))                           // floor층보다 아래층 비트
+#define FLOORS_ABOVE(floor) ((floor_mask_t)(FLOORS_ALL & ~(FLOOR_BIT(floor) | FLOORS_BELOW(floor)))) // floor층보다 위층 비트
+
+// 컴파일 시 비트 수 세기 (#if 안에서도 사용 가능)
+#define BIT_COUNT4(x) (((x) & 1) + (((x) >> 1) & 1) + (((x) >> 2) & 1) + (((x) >> 3) & 1))
+#define BIT_COUNT16(x) (BIT_COUNT4(x) + BIT_COUNT4((x) >> 4) + BIT_COUNT4((x) >> 8) + BIT_COUNT4((x) >> 12))
+
+// 홀 호출 버튼 수 (버튼 순번: 층 순서, 같은 층은 상행 -> 하행)
+#define HALL_CALL_COUNT (BIT_COUNT16(HALL_UP_FLOORS) + BIT_COUNT16(HALL_DOWN_FLOORS))
+#define HALL_CALL_NONE 0xFF // building_hall_index(): 해당 버튼 없음
+
+// =================================================================================
+// --- 74595 Output Bitmap (체인 앞에서부터 차례로 배정) ---
+// 4층 기준: 카 층 0~3, 열기 4, 닫기 5, 벨 6, 조명 7, 홀 호출 8~13, 랜턴 14~21, BCD 22~25
+// =================================================================================
+// 카 내부 LED
+#define LED_CAR_FLOOR_BIT(floor) ((floor) - 1)
+#define LED_CAR_OPEN_BIT (FLOOR_COUNT + 0)
+#define LED_CAR_CLOSE_BIT (FLOOR_COUNT + 1)
+#define LED_CAR_BELL_BIT (FLOOR_COUNT + 2)
+#define LED_CAR_LIGHT_BIT (FLOOR_COUNT + 3)
+// 외부 호출 LED (홀 호출 버튼 순번 순서)
+#define LED_CALL_BASE_BIT (FLOOR_COUNT + 4)
+#define LED_CALL_BIT(index) (LED_CALL_BASE_BIT + (index))
+// 외부 홀 랜턴 LED (층마다 상행, 하행)
+#define LED_LNT_BASE_BIT (LED_CALL_BASE_BIT + HALL_CALL_COUNT)
+#define LED_LNT_BIT(floor, dir) (LED_LNT_BASE_BIT + ((floor) - 1) * 2 + ((dir) == DIR_DESCENDING))
+// 7-세그먼트 BCD 입력
+#define SEG_A_BIT (LED_LNT_BASE_BIT + 2 * FLOOR_COUNT)
+#define SEG_B_BIT (SEG_A_BIT + 1)
+#define SEG_C_BIT (SEG_A_BIT + 2)
+#define SEG_D_BIT (SEG_A_BIT + 3)
+#define LED_COUNT (SEG_A_BIT + 4) // 사용하는 74595 출력 수
+
+// =================================================================================
+// --- 74165 Input Bitmap ---
+// 4층 기준: 카 층 0~3, 열기 4, 닫기 5, 벨 6, 홀 호출 7~12
+// =================================================================================
+#define SW_CAR_FLOOR_BIT(floor) ((floor) - 1)
+#define SW_CAR_OPEN_BIT (FLOOR_COUNT + 0)
+#define SW_CAR_CLOSE_BIT (FLOOR_COUNT + 1)
+#define SW_CAR_BELL_BIT (FLOOR_COUNT + 2)
+#define SW_CALL_BASE_BIT (FLOOR_COUNT + 3)
+#define SW_CALL_BIT(index) (SW_CALL_BASE_BIT + (index))
+#define SW_COUNT (SW_CALL_BASE_BIT + HALL_CALL_COUNT) // 실제 연결된 스위치 수
+
+// =================================================================================
+// --- 홀 호출 버튼 표 ---
+// =================================================================================
+
+/**
+ * @brief 홀 호출 버튼 순번 표를 만듭니다. (init()에서 한 번 호출)
+ */
+void building_init(void);
+
+/**
+ * @brief 층/방향의 홀 호출 버튼 순번 (LED_CALL_BIT(), SW_CALL_BIT()에 사용)
+ * @return 0 ~ HALL_CALL_COUNT-1, 버튼이 없으면 HALL_CALL_NONE
+ */
+uint8_t building_hall_index(uint8_t floor, uint8_t dir);
+
+/**
+ * @brief 홀 호출 버튼 순번의 층
+ */
+uint8_t building_hall_floor(uint8_t index);
+
+/**
+ * @brief 홀 호출 버튼 순번의 방향 (DIR_ASCENDING / DIR_DESCENDING)
+ */
+uint8_t building_hall_dir(uint8_t index);
+
+#endif
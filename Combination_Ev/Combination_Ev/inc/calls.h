@@ -0,0 +1,71 @@
+#ifndef _CALLS_H_
+#define _CALLS_H_
+
+#include "building.h"
+#include "pinmacro.h"
+
+#include <stdint.h>
+
+// =================================================================================
+// --- 호출 등록부 ---
+// 층마다 비트 하나 (bit 0 = 1층): 카 호출, 상행 홀 호출, 하행 홀 호출을 각각 floor_mask_t 비트맵으로 보관
+// 같은 호출은 중복 없이 한 번만 등록되며, 등록 개수 제한이 없어 버려지는 호출이 없습니다.
+// 메인 루프 전용 (ISR에서 호출 금지)
+// =================================================================================
+#define CALLS_CAR 0x01
+#define CALLS_UP 0x02
+#define CALLS_DOWN 0x04
+
+/**
+ * @brief 모든 호출을 지웁니다.
+ */
+void calls_init(void);
+
+/**
+ * @brief 카 내부 층 버튼 호출 등록
+ */
+void calls_add_car(uint8_t floor);
+
+/**
+ * @brief 홀 호출 등록
+ * @param dir DIR_ASCENDING / DIR_DESCENDING
+ */
+void calls_add_hall(uint8_t floor, uint8_t dir);
+
+/**
+ * @brief 해당 층의 호출을 지웁니다.
+ * @param kinds 지울 종류 (CALLS_CAR | CALLS_UP | CALLS_DOWN 조합)
+ */
+void calls_clear(uint8_t floor, uint8_t kinds);
+
+/**
+ * @brief 해당 층에 등록된 호출 종류 (CALLS_* 조합, 없으면 0)
+ */
+uint8_t calls_at(uint8_t floor);
+
+/**
+ * @brief 모든 호출이 있는 층 비트맵 (카 | 상행 | 하행)
+ */
+floor_mask_t calls_all(void);
+
+/**
+ * @brief floor보다 위층에 호출이 있는 층 비트맵
+ */
+floor_mask_t calls_above(uint8_t floor);
+
+/**
+ * @brief floor보다 아래층에 호출이 있는 층 비트맵
+ */
+floor_mask_t calls_below(uint8_t floor);
+
+/**
+ * @brief 세 비트맵을 그대로 복사합니다. (상태 방송, ETA 계산용)
+ */
+void calls_get(floor_mask_t *car, floor_mask_t *up, floor_mask_t *down);
+
+/**
+ * @brief 등록된 호출 개수 (카 + 상행 + 하행)
+ */
+uint8_t calls_count(void);
+
+#endif
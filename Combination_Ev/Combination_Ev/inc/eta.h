@@ -0,0 +1,63 @@
+#ifndef _ETA_H_
+#define _ETA_H_
+
+#include "calls.h"
+#include "pinmacro.h"
+
+#include <stdint.h>
+
+// =================================================================================
+// --- 도착 예상 시간(ETA) 모델 ---
+// 군 운영 시 홀 호출은 ETA가 가장 짧은 카가 맡습니다.
+// 다른 카의 ETA도 상태 방송으로 받은 car_state_t로 같은 모델을 써서 계산합니다.
+// =================================================================================
+#define ETA_FLOOR_MS_INIT 4100U // 층간 주행 시간 초기값 (가감속 포함 1층 이동 실측)
+#define ETA_LEARN_SHIFT 2       // 층간 주행 시간 학습률 (새 측정값 1/4 반영)
+#define ETA_DOOR_MOVE_MS 900U   // 문 열기 또는 닫기 (서보 90도, 20ms당 2도)
+#define ETA_DWELL_MS 5000U      // 앞으로 정지할 층에서 문이 열려 있는 평균 시간 (지금 열린 문은 car_state_t.door_ms)
+#define ETA_STOP_MS (2 * ETA_DOOR_MOVE_MS + ETA_DWELL_MS)
+#define ETA_UNAVAILABLE 0xFFFFU // 비상/과적 등으로 배정 불가
+
+// car_state_t.flags
+#define CAR_FLAG_OVERLOAD 0x01
+#define CAR_FLAG_EMERGENCY 0x02
+
+// 카 상태 스냅샷 (ETA 계산 및 카 간 상태 방송 페이로드)
+typedef struct
+{
+  uint8_t car_id;     // 카 번호 (CAR_ID)
+  int16_t position;   // 스텝모터 위치 (Full Step, 1층 = 0)
+  uint8_t floor;      // 현재 층
+  uint8_t next_stop;  // 이동 중 정지 가능한 가장 가까운 층
+  uint8_t state;      // ST_*
+  uint8_t motion_dir; // 이동 방향 (정지 중 DIR_IDLE)
+  uint8_t travel_dir; // LOOK 운행 방향
+  floor_mask_t car_calls;  // 호출 비트맵 (bit 0 = 1층, 크기는 FLOOR_COUNT에 따름)
+  floor_mask_t up_calls;
+  floor_mask_t down_calls;
+  int16_t load_g;     // 적재 무게 (g)
+  uint8_t flags;      // CAR_FLAG_*
+  uint16_t floor_ms;  // 학습된 층간 주행 시간
+  uint16_t door_ms;   // ST_DOOR_OPENED: 문 닫기 시작까지 남은 유지 시간 (TMR_DOOR_HOLD), 그 외 0
+} car_state_t;
+
+/**
+ * @brief car가 floor층 dir 방향 홀 호출에 도착하기까지의 예상 시간
+ * 현재 위치/운행 방향/문 상태에서 LOOK 순서대로 등록된 정지 층을 거쳐 가는 시간을 계산합니다.
+ * @return 예상 시간 (ms), 배정 불가면 ETA_UNAVAILABLE
+ */
+uint16_t eta_estimate(const car_state_t *car, uint8_t floor, uint8_t dir);
+
+/**
+ * @brief 운행 1회의 실측 시간으로 층간 주행 시간을 학습합니다. (도착 시 호출)
+ * @param floors 이동한 층 수
+ * @param ms 출발부터 도착까지 걸린 시간
+ */
+void eta_learn_trip(uint8_t floors, uint16_t ms);
+
+/**
+ * @brief 학습된 층간 주행 시간 (ms)
+ */
+uint16_t eta_floor_ms(void);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef _EVENT_H_
+#define _EVENT_H_
+
+#include "pinmacro.h"
+
+#include <stdint.h>
+
+// =================================================================================
+// --- 이벤트 종류 ---
+// ISR은 이벤트 레코드만 큐에 넣고, 실제 처리는 메인 루프에서 합니다.
+// =================================================================================
+#define EVT_HOME 1          // 홈 리미트 스위치 눌림 (위치 보정은 ISR에서 완료)
+#define EVT_DOOR_OBSTACLE 2 // 문 닫힘 리미트 스위치 눌림
+// 버튼은 인터럽트 대신 switch_task()가 주기적으로 샘플링, UART 수신은 uart.c 링 버퍼 사용
+
+#define EVENT_QUEUE_SIZE 16 // 2의 거듭제곱이어야 함
+
+typedef struct
+{
+  uint8_t type;  // EVT_*
+  uint16_t data; // 종류별 데이터
+} event_t;
+
+/**
+ * @brief 이벤트를 큐에 넣습니다. ISR 전용 (생산자)
+ * AVR ISR은 중첩되지 않으므로 여러 ISR이 넣어도 생산자는 항상 하나입니다.
+ * @return 1: 성공, 0: 큐가 가득 차서 버림
+ */
+uint8_t event_push(uint8_t type, uint16_t data);
+
+/**
+ * @brief 가장 오래된 이벤트를 꺼냅니다. 메인 루프 전용 (소비자)
+ * @return 1: 꺼냄, 0: 큐가 비어 있음
+ */
+uint8_t event_pop(event_t *ev);
+
+/**
+ * @brief 큐가 가득 차서 버려진 이벤트 수 (디버깅용)
+ */
+uint8_t event_dropped(void);
+
+#endif
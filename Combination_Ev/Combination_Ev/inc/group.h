@@ -0,0 +1,60 @@
+#ifndef _GROUP_H_
+#define _GROUP_H_
+
+#include "eta.h"
+#include "link.h"
+#include "pinmacro.h"
+
+#include <stdint.h>
+
+// =================================================================================
+// --- 군 관리: 같은 뱅크의 다른 카 상태 테이블 ---
+// 상태 방송(LINK_MSG_STATE)을 받을 때마다 갱신하고, LINK_PEER_TIMEOUT_MS 동안
+// 소식이 없는 카는 테이블에서 빠집니다.
+// =================================================================================
+
+/**
+ * @brief 다른 카의 상태를 갱신합니다. (살아 있는 카로 표시)
+ */
+void group_update(const car_state_t *state);
+
+/**
+ * @brief 제한 시간이 지난 카를 테이블에서 뺍니다.
+ * @return 이번에 빠진 카 비트맵 (비트 = 카 번호)
+ */
+uint8_t group_expire(void);
+
+/**
+ * @brief 살아 있는 다른 카 비트맵 (비트 = 카 번호, 자기 자신 제외)
+ */
+uint8_t group_alive(void);
+
+/**
+ * @brief 살아 있는 다른 카 수 (0 = 단독 운영)
+ */
+uint8_t group_count(void);
+
+/**
+ * @brief 카 번호의 마지막 상태 (살아 있는지는 group_alive()로 확인)
+ */
+const car_state_t *group_peer(uint8_t id);
+
+/**
+ * @brief 살아 있는 다른 카들이 맡은 홀 호출 합집합
+ */
+void group_hall_calls(floor_mask_t *up, floor_mask_t *down);
+
+/**
+ * @brief 홀 호출을 맡을 카를 고릅니다. (ETA가 가장 짧은 카, 같으면 번호가 작은 카)
+ * @param me 이 카의 현재 상태
+ * @return 카 번호 (CAR_ID면 이 카)
+ */
+uint8_t group_best_car(const car_state_t *me, uint8_t floor, uint8_t dir);
+
+/**
+ * @brief 살아 있는 카 중(자기 포함) 번호가 가장 작은지 확인합니다.
+ * 끊긴 카의 호출을 인수하는 등 한 대만 해야 하는 일을 정할 때 씁니다.
+ */
+uint8_t group_is_leader(void);
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef _HAL_H_
+#define _HAL_H_
+
+#include "pinmacro.h"
+
+#include <stdint.h>
+
+// =================================================================================
+// --- 하드웨어 추상화 계층 (HAL) ---
+// 드라이버(src/)는 레지스터 대신 이 함수들만 사용합니다.
+// - AVR 백엔드: src/hal_avr.c (ATmega328P 레지스터, 인터럽트 벡터)
+// - 호스트 백엔드: host/hal_host.c (HAL_HOST 정의 시, 스텝모터/서보/스위치/HX711/시프트 레지스터 시뮬레이션)
+// 인터럽트는 백엔드가 받아서 드라이버의 *_on_*() / *_tick() 처리 함수를 호출합니다.
+// =================================================================================
+
+#ifndef HAL_HOST
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+
+// ISR과 공유하는 값을 읽고 쓰는 구간 (인터럽트 금지, 이전 상태로 복구)
+#define HAL_ATOMIC_BLOCK ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+
+// 상수 테이블을 플래시에 두고 읽기
+#define HAL_PROGMEM PROGMEM
+#define hal_rom_byte(addr) pgm_read_byte(addr)
+#else
+// 호스트: 인터럽트는 hal_idle()/hal_delay_*() 안에서만 처리되므로 금지 플래그만 관리
+// avr-libc의 ATOMIC_BLOCK처럼 블록 안에서 return 해도 cleanup으로 복구됨
+uint8_t hal_irq_save(void);
+void hal_irq_restore(const uint8_t *state);
+#define HAL_ATOMIC_BLOCK for (uint8_t hal_sreg_ __attribute__((cleanup(hal_irq_restore))) = hal_irq_save(), hal_once_ = 1; hal_once_; hal_once_ = 0)
+
+#define HAL_PROGMEM
+#define hal_rom_byte(addr) (*(const uint8_t *)(addr))
+#endif
+
+// =================================================================================
+// --- 시스템 ---
+// =================================================================================
+
+/**
+ * @brief 전역 인터럽트를 허용합니다.
+ */
+void hal_irq_enable(void);
+
+/**
+ * @brief 다음 인터럽트(최대 1ms 후 틱)까지 CPU를 쉬게 합니다.
+ */
+void hal_idle(void);
+
+/**
+ * @brief 바쁜 대기 (인터럽트는 그대로 처리됨)
+ */
+void hal_delay_us(uint16_t us);
+void hal_delay_ms(uint16_t ms);
+
+// =================================================================================
+// --- 1ms 시스템 틱 (sched.c) ---
+// =================================================================================
+
+/**
+ * @brief 1kHz 틱 타이머를 시작합니다. 틱마다 sched_tick()을 호출합니다.
+ */
+void hal_tick_init(void);
+
+// =================================================================================
+// --- 74HC595 / 74HC165 체인 (SPI) ---
+// =================================================================================
+
+/**
+ * @brief SPI 마스터(8MHz)와 595 래치, 165 로드 핀을 초기화합니다.
+ */
+void hal_spi_init(void);
+
+/**
+ * @brief 1바이트를 주고받습니다. (MSB First)
+ */
+uint8_t hal_spi_transfer(uint8_t data);
+
+/**
+ * @brief 165 체인에 현재 스위치 상태를 병렬로 읽어 들입니다. (PL 펄스)
+ */
+void hal_165_load(void);
+
+/**
+ * @brief 595 래치(RCLK) 레벨. LOW -> HIGH에서 시프트된 값이 출력으로 나갑니다.
+ */
+void hal_595_latch(uint8_t level);
+
+// =================================================================================
+// --- 입력 핀 (리미트 스위치, HX711 DT) ---
+// 핀 변화가 있으면 isr_on_pin_change()가 호출됩니다.
+// =================================================================================
+#define HAL_IN_HX711_DT 0x01    // HX711 DT (LOW = 변환 완료)
+#define HAL_IN_HOME 0x02        // 홈 스위치 (Active Low)
+#define HAL_IN_DOOR_CLOSED 0x04 // 문 닫힘 스위치 (Active Low, 장애물 감지)
+
+/**
+ * @brief 리미트 스위치 입력과 핀 변화 인터럽트를 설정합니다.
+ */
+void hal_inputs_init(void);
+
+/**
+ * @brief 입력 핀 레벨 (HAL_IN_* 비트, 1 = HIGH)
+ */
+uint8_t hal_inputs(void);
+
+// =================================================================================
+// --- HX711 ---
+// =================================================================================
+
+/**
+ * @brief SCK 출력, DT 입력으로 설정합니다.
+ */
+void hal_hx711_init(void);
+
+/**
+ * @brief SCK 레벨
+ */
+void hal_hx711_sck(uint8_t level);
+
+/**
+ * @brief DT 하강(변환 완료) 시 핀 변화 인터럽트 허용/금지
+ */
+void hal_hx711_irq(uint8_t enable);
+
+// =================================================================================
+// --- 스텝모터 (ULN2003 + 스텝 타이머) ---
+// =================================================================================
+#define HAL_STEP_TIMER_HZ (F_CPU / 1024UL) // 스텝 타이머 틱 (64us)
+
+/**
+ * @brief 코일 핀을 출력(LOW)으로, 스텝 타이머를 정지 상태로 설정합니다.
+ */
+void hal_stepper_init(void);
+
+/**
+ * @brief 4비트 코일 패턴 출력 (bit 0 = 코일 1)
+ */
+void hal_stepper_coils(uint8_t pattern);
+
+/**
+ * @brief 스텝 타이머를 시작합니다. ticks 틱마다 stepper_on_timer()를 호출합니다.
+ */
+void hal_step_timer_start(uint8_t ticks);
+
+/**
+ * @brief 다음 스텝까지의 간격을 바꿉니다. (stepper_on_timer() 안에서 호출)
+ */
+void hal_step_timer_period(uint8_t ticks);
+
+/**
+ * @brief 스텝 타이머를 정지합니다.
+ */
+void hal_step_timer_stop(void);
+
+// =================================================================================
+// --- 서보 (50Hz PWM) ---
+// =================================================================================
+
+/**
+ * @brief 50Hz PWM 출력을 시작합니다.
+ */
+void hal_servo_init(void);
+
+/**
+ * @brief 펄스 폭 (us), 다음 PWM 주기부터 적용
+ */
+void hal_servo_pulse(uint16_t us);
+
+/**
+ * @brief PWM 주기(20ms)마다 servo_on_period() 호출 허용/금지
+ */
+void hal_servo_period_irq(uint8_t enable);
+
+// =================================================================================
+// --- UART / RS-485 ---
+// =================================================================================
+#define HAL_UART_TX_IRQ_OFF 0   // 송신 인터럽트 없음
+#define HAL_UART_TX_IRQ_READY 1 // 송신 레지스터가 비면 uart_on_tx_ready()
+#define HAL_UART_TX_IRQ_DONE 2  // 마지막 비트까지 나가면 uart_on_tx_done()
+
+/**
+ * @brief 8N1, U2X로 송수신을 시작합니다. 수신 바이트마다 uart_on_rx()를 호출합니다.
+ */
+void hal_uart_init(uint32_t baudrate);
+
+/**
+ * @brief 송신 레지스터에 1바이트를 씁니다. (uart_on_tx_ready() 안에서 호출)
+ */
+void hal_uart_write(uint8_t data);
+
+/**
+ * @brief 송신 인터럽트 종류 (HAL_UART_TX_IRQ_*)
+ */
+void hal_uart_tx_irq(uint8_t mode);
+
+/**
+ * @brief RS-485 트랜시버 송신 허용 (DE)
+ */
+void hal_rs485_de(uint8_t enable);
+
+// =================================================================================
+// --- 백엔드가 호출하는 드라이버 처리 함수 ---
+// =================================================================================
+void sched_tick(void);
+void stepper_on_timer(void);
+void servo_on_period(void);
+void uart_on_tx_ready(void);
+void uart_on_tx_done(void);
+void uart_on_rx(uint8_t data, uint8_t overrun);
+void isr_on_pin_change(uint8_t pins);
+
+#endif
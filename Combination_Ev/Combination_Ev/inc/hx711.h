@@ -1,6 +1,7 @@
 #ifndef LOADCELL_H_
 #define LOADCELL_H_
 
+#include "hal.h"
 #include "pinmacro.h"
 
 #include <stdbool.h>
@@ -10,6 +11,17 @@
 // 이 값들을 수정하여 엘리베이터의 사양을 쉽게 변경할 수 있습니다.
 #define ELEVATOR_CAPACITY_G 1000L // 엘리베이터 최대 허용 무게 (1000g = 1kg)
 #define TARE_SAMPLE_COUNT 10      // 0점 설정 시 10번 측정하여 평균을 내어 정확도를 높입니다.
+#define LOADCELL_MEDIAN_SIZE 5    // 이동 중앙값 창 크기 (홀수, 10Hz 기준 0.5초)
+#define LOADCELL_IIR_SHIFT 2      // 중앙값 뒤 1차 IIR 계수 = 1/2^n (10Hz 기준 시정수 약 0.4초)
+#define LOADCELL_HYSTERESIS_G 50L // 과적 해제 기준 = 최대 허용 무게 - 50g (경계 부근 떨림 방지)
+
+// --- 캘리브레이션 ---
+// 1g당 raw 카운트 (10.7143)를 Q16.16 고정소수점으로 저장합니다. (10.7143 * 65536)
+#define LOADCELL_SCALE_Q16 702173L
+// 무게 변환용 역수 (g/카운트, Q16.16): 2^32 / LOADCELL_SCALE_Q16 (반올림)
+#define LOADCELL_RECIP_Q16 ((int32_t)((0x100000000ULL + LOADCELL_SCALE_Q16 / 2) / LOADCELL_SCALE_Q16))
+// delta * LOADCELL_RECIP_Q16이 32비트를 넘지 않는 최대 raw 변화량 (약 ±35kg)
+#define LOADCELL_DELTA_LIMIT (0x7FFFFFFFL / LOADCELL_RECIP_Q16)
 
 // =================================================================================
 // --- 함수 선언부 ---
@@ -25,22 +37,38 @@ void loadcell_init(void);
 /**
  * @brief 현재 로드셀의 측정값을 0점(기준점)으로 설정합니다.
  * 엘리베이터가 비어있을 때 호출하여 영점을 맞춥니다.
+ * 영점 측정이 끝나면 DT(PC0, PCINT8) 핀 변화 인터럽트로 백그라운드 측정을 시작합니다.
  */
 void loadcell_tare(void);
 
 /**
- * @brief 현재 측정된 무게를 킬로그램(kg) 단위로 변환하여 반환합니다.
- * @return float 현재 무게(kg)
+ * @brief 필터링된 최근 측정값을 그램(g) 단위로 변환하여 반환합니다. 대기하지 않습니다.
+ * 정수 곱셈과 시프트만 사용합니다. (부동소수점 미사용)
+ * @return int32_t 현재 무게(g)
  */
-float loadcell_get_weight_g(void);
+int32_t loadcell_get_weight_g(void);
 
 /**
- * @brief 현재 무게가 설정된 최대 허용 무게(ELEVATOR_CAPACITY_KG)를 초과했는지 확인합니다.
+ * @brief 과적 상태를 반환합니다. 대기하지 않습니다.
+ * 과적 상태는 측정마다 필터 출력을 raw 임계값과 비교해 갱신되며,
+ * ELEVATOR_CAPACITY_G를 넘으면 진입하고 LOADCELL_HYSTERESIS_G만큼 내려가야 해제됩니다.
  * @return bool 과적 상태이면 true, 아니면 false를 반환합니다.
  */
 bool loadcell_is_overload(void);
 
-// RAW값 반환
+// 가장 최근에 읽은 RAW값 반환
 long loadcell_get_raw_value(void);
 
+/**
+ * @brief DT 핀이 LOW(변환 완료)일 때 핀 변화 인터럽트(isr_on_pin_change())에서 호출됩니다.
+ * DT 인터럽트를 끄고 플래그만 세웁니다. 읽기와 필터는 loadcell_poll()이 수행합니다.
+ */
+void loadcell_on_data_ready(void);
+
+/**
+ * @brief 변환 완료 플래그가 있으면 24비트 값을 읽어 중앙값 -> IIR 필터를 갱신하고 과적 상태를 판정합니다.
+ * 메인 루프에서 매번 호출합니다. 인터럽트는 SCK HIGH 펄스(약 1us) 동안만 막습니다.
+ */
+void loadcell_poll(void);
+
 #endif /* LOADCELL_H_ */
\ No newline at end of file
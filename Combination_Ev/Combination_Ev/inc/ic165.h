@@ -1,13 +1,51 @@
 #ifndef _IC165_H_
 #define _IC165_H_
 
+#include "building.h"
+#include "hal.h"
 #include "pinmacro.h"
 
-#include <avr/interrupt.h>
-#include <avr/io.h>
 #include <stdint.h>
-#include <util/delay.h>
 
-uint16_t ic165_read();
+// 체인 길이 (74HC165 개수 = 바이트 수), 기본값은 building.h의 스위치 수를 담을 만큼
+#ifndef IC165_CHAIN_BYTES
+#define IC165_CHAIN_BYTES ((SW_COUNT + 7) / 8)
+#endif
+
+#if SW_COUNT > IC165_CHAIN_BYTES * 8
+#error "74165 체인보다 스위치가 많습니다 (층 수/홀 버튼 수 확인)"
+#endif
+
+// 스위치 바이트 배열에서 한 비트 확인 (bit n = buf[n / 8]의 n % 8)
+#define IC165_BIT(buf, bit) ((buf)[(bit) >> 3] & (1 << ((bit) & 7)))
+
+#define IC165_SCAN_PERIOD_MS 5 // 샘플링 주기 (4회 연속 일치 = 20ms 디바운스)
+
+/**
+ * @brief 165 체인 샘플 하나로 연결된 스위치(SW_COUNT개)를 한꺼번에 디바운스합니다.
+ * IC165_SCAN_PERIOD_MS마다 메인 루프에서 ic595_exchange()로 읽은 샘플을 넘깁니다.
+ * @param sample IC165_CHAIN_BYTES 바이트 (Active Low 원시값)
+ */
+void ic165_scan(const uint8_t *sample);
+
+/**
+ * @brief 디바운스된 스위치 상태 (Active High, 1 = 눌림)
+ * @param state IC165_CHAIN_BYTES 바이트
+ */
+void ic165_state(uint8_t *state);
+
+/**
+ * @brief 마지막 호출 이후 새로 눌린 스위치 (Active High) - 읽으면 지워짐
+ * @param press IC165_CHAIN_BYTES 바이트
+ * @return 새로 눌린 스위치가 있으면 1
+ */
+uint8_t ic165_get_press(uint8_t *press);
+
+/**
+ * @brief 마지막 호출 이후 떼어진 스위치 (Active High) - 읽으면 지워짐
+ * @param release IC165_CHAIN_BYTES 바이트
+ * @return 떼어진 스위치가 있으면 1
+ */
+uint8_t ic165_get_release(uint8_t *release);
 
 #endif
\ No newline at end of file
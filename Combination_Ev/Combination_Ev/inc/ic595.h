@@ -1,15 +1,40 @@
 #ifndef _IC595_H_
 #define _IC595_H_
 
+#include "building.h"
+#include "hal.h"
 #include "pinmacro.h"
 
-#include <avr/io.h>
+#include <stddef.h>
 #include <stdint.h>
-#include <util/delay.h>
 
+// 체인 길이 (74HC595 개수 = 바이트 수), 기본값은 building.h의 출력 수를 담을 만큼
+// 보드를 더 이어 붙였으면 -DIC595_CHAIN_BYTES=6 처럼 실제 개수로 빌드
+#ifndef IC595_CHAIN_BYTES
+#define IC595_CHAIN_BYTES ((LED_COUNT + 7) / 8)
+#endif
+
+#if LED_COUNT > IC595_CHAIN_BYTES * 8
+#error "74595 체인보다 출력이 많습니다 (층 수/홀 버튼 수 확인)"
+#endif
+
+/**
+ * @brief 출력 버퍼가 바뀌었을 때만 체인 전체를 한 번의 SPI 버스트로 래치합니다.
+ */
 void ic595_update();
+
+/**
+ * @brief 595 출력 래치와 165 입력 읽기를 한 번의 SPI 버스트로 수행합니다.
+ * @param input 165 체인 입력 (IC165_CHAIN_BYTES 바이트, bit n = input[n / 8]의 n % 8), 필요 없으면 NULL
+ */
+void ic595_exchange(uint8_t *input);
+
+/**
+ * @brief 체인 전체(IC595_CHAIN_BYTES * 8 출력)를 끕니다. 다음 ic595_update()에서 전송됩니다.
+ */
+void ic595_clear();
+
 void ic595_fndset(uint8_t num);
 void ic595_ledset(uint8_t pos, uint8_t state);
-uint8_t ic595_fndget();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef _LINK_H_
+#define _LINK_H_
+
+#include "eta.h"
+#include "pinmacro.h"
+#include "sched.h"
+#include "uart.h"
+
+#include <stdint.h>
+
+// =================================================================================
+// --- 카 간 통신 프레임 (RS-485 반이중 공유 버스) ---
+// [SYNC 0xA5] [DST] [SRC] [TYPE] [SEQ] [LEN] [PAYLOAD x LEN] [CRC-8]
+// CRC-8 (다항식 0x07, 초기값 0)은 DST부터 PAYLOAD 끝까지 계산합니다.
+// 오류 프레임은 버리고 다음 SYNC 바이트부터 다시 동기화합니다.
+//
+// 버스 충돌을 막기 위해 시간 분할(TDMA)로 송신합니다.
+// LINK_CYCLE_MS 주기를 카 수만큼 슬롯으로 나누고, 각 카는 자기 번호의 슬롯에서만 송신을 시작합니다.
+// 슬롯 시작 시각은 살아 있는 카 중 번호가 가장 작은 카의 프레임에 맞춰 정렬됩니다.
+// =================================================================================
+#define LINK_SYNC 0xA5
+#define LINK_CRC_POLY 0x07
+#define LINK_MAX_PAYLOAD 24
+#define LINK_OVERHEAD 7 // SYNC + DST + SRC + TYPE + SEQ + LEN + CRC
+#define LINK_BROADCAST 0xFF
+
+#define LINK_MAX_CARS 4 // 한 뱅크의 최대 카 수 (카 번호 0 ~ 3)
+
+#if CAR_ID >= LINK_MAX_CARS
+#error "CAR_ID는 0 ~ LINK_MAX_CARS - 1 이어야 합니다"
+#endif
+#define LINK_SLOT_MS 5  // 카 한 대의 송신 슬롯 (250kbps에서 최대 프레임 약 1.2ms)
+#define LINK_SLOT_GUARD_MS 2 // 슬롯 끝부분은 송신을 시작하지 않음 (시계 오차 여유)
+#define LINK_CYCLE_MS (LINK_MAX_CARS * LINK_SLOT_MS)
+#define LINK_TX_QUEUE_SIZE 4 // 슬롯을 기다리는 송신 프레임 수
+
+// 프레임 종류
+#define LINK_MSG_STATE 0x01  // 카 상태 방송 (payload: car_state_t)
+#define LINK_MSG_ASSIGN 0x02 // 홀 호출 배정 (payload: link_assign_t), 받은 카가 맡음
+#define LINK_MSG_ASSIGN_ACK 0x03 // 배정 수락 (payload: 받은 link_assign_t 그대로), 배정한 카에게만 보냄
+
+// 상태가 페이로드보다 커지면 link_send()가 모든 상태 방송을 버리므로 빌드 단계에서 막음
+_Static_assert(sizeof(car_state_t) <= LINK_MAX_PAYLOAD, "car_state_t가 LINK_MAX_PAYLOAD보다 큽니다");
+
+#define LINK_STATE_PERIOD_MS 100    // 상태 방송 주기
+#define LINK_PEER_TIMEOUT_MS 1000   // 이 시간 동안 상태가 없으면 해당 카는 끊긴 것으로 봄
+#define LINK_HANDOFF_TIMEOUT_MS 500 // 넘긴 호출의 수락(ACK)이 없으면 직접 처리
+
+typedef struct
+{
+  uint8_t floor; // 층 (1 ~ FLOOR_COUNT)
+  uint8_t dir;   // DIR_ASCENDING / DIR_DESCENDING
+} link_assign_t;
+
+typedef struct
+{
+  uint8_t dst; // 받는 카 번호 또는 LINK_BROADCAST
+  uint8_t src; // 보낸 카 번호
+  uint8_t type;
+  uint8_t seq;
+  uint8_t len;
+  uint8_t payload[LINK_MAX_PAYLOAD];
+} link_frame_t;
+
+/**
+ * @brief 프레임을 송신 대기열에 넣습니다. (대기하지 않음)
+ * 실제 송신은 link_poll()이 자기 슬롯에서 수행하며, 순서 번호는 자동으로 증가합니다.
+ * @param dst 받는 카 번호 또는 LINK_BROADCAST
+ * @return 1: 성공, 0: 대기열이 가득 차서 버림
+ */
+uint8_t link_send(uint8_t dst, uint8_t type, const void *payload, uint8_t len);
+
+/**
+ * @brief 자기 슬롯이면 대기 중인 프레임을 UART로 내보냅니다. (1ms마다 호출)
+ */
+void link_poll(void);
+
+/**
+ * @brief 수신 바이트를 파서에 넣습니다.
+ * 이 카가 보낸 프레임(에코)과 다른 카에게 보낸 프레임은 버립니다.
+ * @param frame 완성된 프레임을 받을 버퍼
+ * @return 1: CRC가 맞는 이 카 앞(또는 방송) 프레임 완성, 0: 진행 중 또는 버림
+ */
+uint8_t link_rx_byte(uint8_t byte, link_frame_t *frame);
+
+/**
+ * @brief CRC 오류로 버린 프레임 수
+ */
+uint8_t link_crc_errors(void);
+
+/**
+ * @brief 송신 대기열이 가득 차서 보내지 못한 프레임 수
+ */
+uint8_t link_tx_dropped(void);
+
+/**
+ * @brief 순서 번호 건너뜀으로 추정한 손실 프레임 수 (모든 카 합계)
+ */
+uint8_t link_lost_frames(void);
+
+#endif
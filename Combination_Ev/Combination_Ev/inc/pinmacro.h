@@ -14,16 +14,11 @@
 #define DIR_DESCENDING 1
 #define DIR_IDLE 2
 
-// UART data bit
-#define UART_FLOOR_BIT 0
-#define UART_DIRECTION_BIT 2
-#define UART_ASSIGN_BIT 3
-#define UART_SENDER_BIT 4
-#define UART_SCORE_BIT 5
-#define UART_ASSIGN 0
-#define UART_RETURN 1
-#define UART_EVA 0
-#define UART_EVB 1
+// 이 제어기가 맡은 카 번호 (0 ~ LINK_MAX_CARS - 1), 보드마다 -DCAR_ID=1 처럼 빌드
+// 카 간 통신 프레임 형식은 link.h 참고
+#ifndef CAR_ID
+#define CAR_ID 0
+#endif
 
 // 74 Series IC Control Pins
 #define RCLK_595_DDR DDRB
@@ -95,51 +90,11 @@
 #define UART_TX_PORT PORTD
 #define UART_TX_PIN PD1
 
-// 74595 Output Bitmap
-// 카 내부 LED
-#define LED_CAR_1F_BIT 0
-#define LED_CAR_2F_BIT 1
-#define LED_CAR_3F_BIT 2
-#define LED_CAR_4F_BIT 3
-#define LED_CAR_OPEN_BIT 4
-#define LED_CAR_CLOSE_BIT 5
-#define LED_CAR_BELL_BIT 6
-#define LED_CAR_LIGHT_BIT 7
-// 외부 호출 LED
-#define LED_CALL_1F_UP_BIT 8
-#define LED_CALL_2F_UP_BIT 9
-#define LED_CALL_2F_DOWN_BIT 10
-#define LED_CALL_3F_UP_BIT 11
-#define LED_CALL_3F_DOWN_BIT 12
-#define LED_CALL_4F_DOWN_BIT 13
-// 외부 홀 랜턴 LED
-#define LED_LNT_1F_UP_BIT 14
-#define LED_LNT_1F_DOWN_BIT 15
-#define LED_LNT_2F_UP_BIT 16
-#define LED_LNT_2F_DOWN_BIT 17
-#define LED_LNT_3F_UP_BIT 18
-#define LED_LNT_3F_DOWN_BIT 19
-#define LED_LNT_4F_UP_BIT 20
-#define LED_LNT_4F_DOWN_BIT 21
-// 7-세그먼트 BCD 입력
-#define SEG_A_BIT 22
-#define SEG_B_BIT 23
-#define SEG_C_BIT 24
-#define SEG_D_BIT 25
-
-// 74165 Input Bitmap
-#define SW_CAR_1F_BIT 0
-#define SW_CAR_2F_BIT 1
-#define SW_CAR_3F_BIT 2
-#define SW_CAR_4F_BIT 3
-#define SW_CAR_OPEN_BIT 4
-#define SW_CAR_CLOSE_BIT 5
-#define SW_CAR_BELL_BIT 6
-#define SW_CALL_1F_UP_BIT 7
-#define SW_CALL_2F_UP_BIT 8
-#define SW_CALL_2F_DOWN_BIT 9
-#define SW_CALL_3F_UP_BIT 10
-#define SW_CALL_3F_DOWN_BIT 11
-#define SW_CALL_4F_DOWN_BIT 12
+// RS-485 트랜시버 송신 허용 (DE, Active High) - 공유 버스에서 송신 중에만 HIGH
+#define RS485_DE_DDR DDRD
+#define RS485_DE_PORT PORTD
+#define RS485_DE_PIN PD2
+
+// 74595 출력 / 74165 입력 배치는 층 수에 따라 building.h에서 만들어집니다
 
 #endif
\ No newline at end of file
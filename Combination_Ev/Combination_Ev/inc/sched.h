@@ -0,0 +1,79 @@
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+#include "hal.h"
+#include "pinmacro.h"
+
+#include <stdint.h>
+
+// =================================================================================
+// --- 소프트웨어 타이머 ID ---
+// 모든 타이머는 1ms 틱(sched_tick())에서 감소하며, 단위는 ms입니다.
+// =================================================================================
+#define TMR_DOOR_HOLD 0 // 문 열림 유지 시간
+#define TMR_MOVING 1    // 이동 시간 초과 감시
+#define TMR_LIGHT 2     // 카 조명 자동 소등
+#define TMR_BELL 3      // 벨 LED 점멸 시간
+#define TMR_HANDOFF 4   // 다른 카에 넘긴 홀 호출의 수신 확인 대기
+#define SW_TIMER_COUNT 5
+
+// 주기 태스크 (sched_dispatch()에 테이블로 전달)
+typedef struct
+{
+  uint16_t period_ms; // 실행 주기 (ms)
+  uint16_t last_run;  // 마지막 실행 예정 시각 (sched_millis() 기준)
+  void (*run)(void);
+} sched_task_t;
+
+/**
+ * @brief 1ms 틱 타이머를 시작합니다. (AVR: Timer0 CTC, 64분주, OCR0A = 249)
+ */
+void sched_init(void);
+
+/**
+ * @brief 부팅 후 경과 시간 (ms, 약 65초마다 0으로 돌아감)
+ */
+uint16_t sched_millis(void);
+
+/**
+ * @brief 주기가 된 태스크를 테이블 순서대로 실행합니다.
+ * 실행 예정 시각은 주기만큼 더해지므로 태스크 실행 시간과 무관하게 주기가 유지됩니다.
+ */
+void sched_dispatch(sched_task_t *tasks, uint8_t count);
+
+/**
+ * @brief 다음 인터럽트(최대 1ms 후 틱)까지 CPU를 Idle 슬립시킵니다.
+ */
+void sched_idle(void);
+
+/**
+ * @brief 소프트웨어 타이머를 시작(재시작)합니다. ISR에서도 호출할 수 있습니다.
+ * @param id 타이머 ID (TMR_*)
+ * @param ms 만료까지의 시간 (1 ~ 65535ms)
+ */
+void timer_start(uint8_t id, uint16_t ms);
+
+/**
+ * @brief 소프트웨어 타이머를 만료 이벤트 없이 정지합니다.
+ */
+void timer_stop(uint8_t id);
+
+/**
+ * @brief 타이머가 동작 중인지 확인합니다.
+ * @return 1: 동작 중, 0: 정지 또는 만료
+ */
+uint8_t timer_running(uint8_t id);
+
+/**
+ * @brief 타이머 만료까지 남은 시간
+ * @return 남은 시간 (ms), 정지 또는 만료면 0
+ */
+uint16_t timer_remaining(uint8_t id);
+
+/**
+ * @brief 타이머가 만료되었는지 확인하고 만료 이벤트를 지웁니다. (만료 1회당 한 번만 1 반환)
+ * @return 1: 만료됨, 0: 아님
+ */
+uint8_t timer_fired(uint8_t id);
+
+#endif
@@ -6,10 +6,9 @@
 #ifndef _SERVO_H_
 #define _SERVO_H_
 
+#include "hal.h"
 #include "pinmacro.h"
-#include <avr/io.h>
 #include <stdint.h>
-#include <util/delay.h>
 
 // =================================================================================
 // --- 상수 정의 ---
@@ -31,15 +30,27 @@ void servo_init(void);
 void servo_set_angle(uint8_t angle);
 
 /**
- * @brief 엘리베이터 문을 엽니다.
+ * @brief 서보 모터를 목표 각도로 이동시킵니다. (Timer1 오버플로 인터럽트로 비차단 구동)
+ * @param target_angle 목표 각도 (0 ~ 180도)
+ */
+void servo_move_to(uint8_t target_angle);
+
+/**
+ * @brief 엘리베이터 문 열기를 시작합니다. (비차단)
  */
 void servo_door_open(void);
 
 /**
- * @brief 엘리베이터 문을 닫습니다.
+ * @brief 엘리베이터 문 닫기를 시작합니다. (비차단)
  */
 void servo_door_close(void);
 
+/**
+ * @brief 문(서보)이 이동 중인지 확인합니다.
+ * @return 1: 이동 중, 0: 정지
+ */
+uint8_t servo_door_busy(void);
+
 /**
  * @brief 현재 문이 열려있는지 확인합니다.
  * @return 1: 문 열림, 0: 문 닫힘
@@ -47,7 +58,7 @@ void servo_door_close(void);
 uint8_t servo_door_is_open(void);
 
 /**
- * @brief 서보 모터를 특정 각도로 부드럽게 이동시킵니다.
+ * @brief 서보 모터를 특정 각도로 부드럽게 이동시킵니다. (완료까지 대기)
  * @param target_angle 목표 각도 (0 ~ 180도)
  * @param step_delay 각 스텝(1도) 사이의 지연시간 (ms)
  */
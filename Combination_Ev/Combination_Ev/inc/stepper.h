@@ -1,11 +1,10 @@
 #ifndef _STEPPER_H_
 #define _STEPPER_H_
 
+#include "building.h"
+#include "hal.h"
 #include "pinmacro.h"
-#include <avr/interrupt.h>
-#include <avr/io.h>
 #include <stdint.h>
-#include <util/delay.h>
 
 // =================================================================================
 // --- 함수 프로토타입 ---
@@ -23,12 +22,40 @@ void stepper_init(void);
 void stepper_step(uint8_t step_pattern);
 
 /**
- * @brief 지정된 스텝 수만큼 모터 이동
+ * @brief 지정된 스텝 수만큼 모터 이동 (완료까지 대기)
  * @param steps 이동할 스텝 수
  * @param direction 방향 (1: 시계방향, 0: 반시계방향)
  */
 void stepper_move_steps(int16_t steps, uint8_t direction);
 
+/**
+ * @brief 목표 위치로의 이동 시작 (스텝 타이머 인터럽트로 비차단 구동)
+ * @param position 목표 위치 (스텝 단위, 절대 위치)
+ */
+void stepper_move_to(int32_t position);
+
+/**
+ * @brief 이동 중인 목표 위치를 변경합니다. (연장 또는 단축)
+ * 현재 속도에서 감속 거리 안에 들어온 위치나 진행 방향 뒤쪽은 거절됩니다.
+ * 정지 중이면 stepper_move_to()와 같습니다.
+ * @param position 새 목표 위치 (스텝 단위, 절대 위치)
+ * @return 1: 수락, 0: 거절 (기존 목표 유지)
+ */
+uint8_t stepper_retarget(int32_t position);
+
+/**
+ * @brief 이동 중인 목표 층을 변경합니다. (stepper_retarget()의 층 단위 버전)
+ * @param target_floor 새 목표 층 (1~FLOOR_COUNT)
+ * @return 1: 수락, 0: 거절 (기존 목표 유지)
+ */
+uint8_t stepper_retarget_floor(uint8_t target_floor);
+
+/**
+ * @brief 모터 이동 중 여부
+ * @return 1: 이동 중, 0: 정지
+ */
+uint8_t stepper_is_busy(void);
+
 /**
  * @brief 모터를 정확한 각도로 회전
  * @param degrees 회전할 각도 (양수: 시계방향, 음수: 반시계방향)
@@ -58,10 +85,23 @@ int32_t stepper_get_position(void);
 void stepper_reset_position(void);
 
 /**
- * @brief 엘리베이터를 특정 층으로 이동
- * @param target_floor 목표 층 (1~4)
- * @param current_floor 현재 층 (1~4)
+ * @brief 엘리베이터를 특정 층으로 이동 시작 (비차단)
+ * @param target_floor 목표 층 (1~FLOOR_COUNT)
+ * @param current_floor 현재 층 (1~FLOOR_COUNT)
  */
 void stepper_move_to_floor(uint8_t target_floor, uint8_t current_floor);
 
+/**
+ * @brief 현재 위치에서 가장 가까운 층 (층 사이 중간 지점을 지나면 다음 층)
+ * @return 층 (1~FLOOR_COUNT)
+ */
+uint8_t stepper_get_floor(void);
+
+/**
+ * @brief 지금 감속을 시작하면 멈출 수 있는 진행 방향의 가장 가까운 층
+ * 정지 중이면 현재 층을 반환합니다.
+ * @return 층 (1~FLOOR_COUNT)
+ */
+uint8_t stepper_next_stop_floor(void);
+
 #endif
\ No newline at end of file
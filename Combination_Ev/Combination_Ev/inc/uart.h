@@ -1,16 +1,57 @@
 #ifndef _UART_H_
 #define _UART_H_
 
+#include "hal.h"
 #include "pinmacro.h"
 
-#include <avr/io.h>
+#define UART_BAUD 250000UL         // 카 간 통신 속도 (U2X, 16MHz에서 오차 0%)
+
+#define UART_TX_BUF_SIZE 64 // 2의 거듭제곱이어야 함
+#define UART_RX_BUF_SIZE 64 // 2의 거듭제곱이어야 함
+
 #include <stdint.h>
 
-void uart_init(uint16_t baudrate);
-void uart_tx_byte(uint8_t data);
+/**
+ * @brief UART0 초기화 (8N1, 배속 모드, 송수신 인터럽트, RS-485 반이중)
+ * @param baudrate 통신 속도 (bps)
+ */
+void uart_init(uint32_t baudrate);
+
+/**
+ * @brief 송신 버퍼에 한 바이트를 넣습니다. 대기하지 않으며, 버퍼가 가득 차면 버리고 개수를 셉니다.
+ * @return 1: 성공, 0: 버림
+ */
+uint8_t uart_tx_byte(uint8_t data);
+
+/**
+ * @brief 송신 버퍼의 빈 공간 (바이트)
+ */
+uint8_t uart_tx_free(void);
+
+/**
+ * @brief 송신 중인지 확인합니다. (버퍼에 남은 데이터가 있거나 마지막 바이트가 나가는 중)
+ */
+uint8_t uart_tx_busy(void);
+
+/**
+ * @brief 수신 버퍼에서 한 바이트를 꺼냅니다. (대기하지 않음)
+ * @return 1: 꺼냄, 0: 버퍼가 비어 있음
+ */
+uint8_t uart_rx_read(uint8_t *data);
+
+/**
+ * @brief 수신 버퍼에서 한 바이트를 꺼냅니다. (도착할 때까지 대기)
+ */
 uint8_t uart_rx_byte();
-void uart_tx_data(uint8_t score, uint8_t floor, uint8_t dir, uint8_t assign);
-void enqueue(uint8_t floor, uint8_t dir);
-void dequeue();
 
-#endif
\ No newline at end of file
+/**
+ * @brief 송신 버퍼가 가득 차서 버린 바이트 수
+ */
+uint8_t uart_tx_overflows(void);
+
+/**
+ * @brief 수신 버퍼가 가득 차거나 하드웨어 오버런(DOR0)으로 잃은 바이트 수
+ */
+uint8_t uart_rx_overflows(void);
+
+#endif
@@ -1,41 +1,62 @@
+#include "building.h"
+#include "calls.h"
+#include "eta.h"
+#include "event.h"
+#include "group.h"
+#include "hal.h"
 #include "hx711.h"
 #include "ic165.h"
 #include "ic595.h"
+#include "link.h"
 #include "pinmacro.h"
+#include "sched.h"
 #include "servo.h"
 #include "stepper.h"
 #include "uart.h"
 
-#include <avr/interrupt.h>
-#include <avr/io.h>
 #include <stdint.h>
-#include <util/delay.h>
+#include <string.h>
+
+// 시간 설정 (ms, 소프트웨어 타이머 사용)
+#define DOOR_HOLD_MS 50000U             // 문 열림 유지 시간 (50초)
+#define MOVING_TIMEOUT_PER_FLOOR_MS 12000U // 층당 이동 시간 한도 (12초)
+#define LIGHT_ON_MS 3000U               // 조명 자동 소등 (3초)
+#define BELL_BLINK_MS 3000U             // 벨 LED 점멸 시간 (3초)
+
+// 이동 시간 감시는 층 경계마다 다시 시작하므로 한 번에 한 층 분량만 잽니다.
+// FLOOR_COUNT(최대 16층)와 무관하게 uint16_t ms 소프트웨어 타이머에 들어가야 함
+_Static_assert(MOVING_TIMEOUT_PER_FLOOR_MS <= UINT16_MAX, "MOVING_TIMEOUT_PER_FLOOR_MS가 timer_start() 범위를 넘습니다");
+
+// 태스크 주기 (ms)
+#define TASK_LINK_PERIOD_MS 100    // 운영 모드(카 간 링크) 감시
+#define TASK_LINK_TX_PERIOD_MS 1   // 링크 송신 (자기 TDMA 슬롯에서만 실제 송신)
+#define TASK_SWITCH_PERIOD_MS IC165_SCAN_PERIOD_MS // 버튼 샘플링 + 디바운스
+#define TASK_SAFETY_PERIOD_MS 20   // 안전 검사
+#define TASK_DISPATCH_PERIOD_MS 10 // 작업 큐 + 상태머신
+#define TASK_DISPLAY_PERIOD_MS 50  // LED/FND 갱신 (점멸 주기 기준)
 
-#define DOOR_HOLD_TIME 1000
-
-volatile uint16_t swinput = 0xFFFF;
-volatile uint16_t door_holding = 0;
 volatile uint8_t ev_current_dir = DIR_IDLE;
+volatile uint8_t ev_travel_dir = DIR_IDLE;   // 운행 방향 (LOOK: 앞쪽 호출이 없을 때만 반전, 도착 후에도 유지)
 volatile uint8_t ev_current_floor = 1;
+volatile uint8_t ev_next_stop_floor = 1;     // 이동 중 아직 정지할 수 있는 진행 방향의 가장 가까운 층
 volatile uint8_t ev_state = ST_IDLE;
-volatile uint16_t g_light_timer_count = 0; // 3초 조명 타이머를 위한 카운트 변수
-volatile uint8_t task_queue[5] = {0};
 volatile uint8_t target_floor = 0;           // 목표 층
 volatile uint8_t emergency_flag = 0;         // 비상 정지 플래그
-volatile uint16_t moving_timer = 0;          // 이동 시간 타이머
-volatile uint16_t system_timer = 0;          // 시스템 틱 카운터
-volatile uint16_t bell_led_timer_global = 0; // 벨 LED 타이머
+volatile uint16_t system_timer = 0;          // 디스플레이 프레임 카운터 (50ms마다 증가, 점멸용)
 
-<<<<<<< HEAD
-volatile uint32_t state = 0;
-=======
 // 운영 모드 관리
-volatile uint8_t operation_mode = 0;        // 0: 단독, 1: 2대 운영
-volatile uint16_t uart_timeout_counter = 0; // UART 통신 타임아웃
-volatile uint8_t last_uart_received = 0;    // 마지막 UART 수신 시간
+volatile uint8_t operation_mode = 0;        // 살아 있는 다른 카 수 (0: 단독 운영)
+
+// 운행 시간 측정 (층간 주행 시간 학습용)
+static uint16_t trip_start_ms = 0;
+static uint8_t trip_start_floor = 1;
+
+// 군 운영: 다른 카 상태는 group.c의 테이블이 관리
+static link_frame_t rx_frame;
+static floor_mask_t handoff_up = 0;   // 다른 카에 넘겼지만 아직 수락(ACK)을 받지 못한 홀 호출
+static floor_mask_t handoff_down = 0;
 
 // 함수 프로토타입 선언
->>>>>>> 1f27fee4a23132facf9a3edd74fd4b5bf8e1d406
 void init();
 void safety_check();
 void process_task_queue();
@@ -46,15 +67,44 @@ void handle_door_opened_state();
 void handle_door_closing_state();
 void update_display();
 uint8_t get_next_task();
+uint8_t next_stop_ahead(uint8_t from, uint8_t dir);
+uint8_t stop_kinds_at(uint8_t floor);
+void serve_stop(uint8_t floor);
 void start_moving_to_floor(uint8_t target_floor);
+void start_door_opening();
+void start_door_closing();
 void check_floor_arrival();
+void update_moving_target();
 void emergency_stop();
 void turn_off_car_button_led(uint8_t floor);
 void turn_off_call_button_led(uint8_t floor, uint8_t direction);
+void set_call_button_led(uint8_t floor, uint8_t direction, uint8_t state);
+void serve_floor(uint8_t floor, uint8_t kinds);
 void init_all_leds();
 void set_bell_led_timer();
 void check_operation_mode();
 void handle_external_call(uint8_t floor, uint8_t direction);
+void dispatch_task();
+void process_events();
+void switch_task();
+void handle_switch_event(const uint8_t *pressed);
+void handle_uart_event(uint8_t rxbuf);
+void handle_link_frame(link_frame_t *frame);
+void broadcast_state();
+void get_car_state(car_state_t *car);
+void sync_hall_lamps();
+void take_over_calls(floor_mask_t up, floor_mask_t down);
+
+// 주기 태스크 테이블 (같은 틱에 주기가 겹치면 위에서부터 실행)
+static sched_task_t tasks[] = {
+    {TASK_LINK_PERIOD_MS, 0, check_operation_mode}, // 0. 운영 모드 감지
+    {LINK_STATE_PERIOD_MS, 0, broadcast_state},     // 1. 상태 방송
+    {TASK_LINK_TX_PERIOD_MS, 0, link_poll},         // 1-1. TDMA 슬롯 송신
+    {TASK_SWITCH_PERIOD_MS, 0, switch_task},        // 2. 버튼 샘플링 + 디바운스
+    {TASK_SAFETY_PERIOD_MS, 0, safety_check},       // 3. 안전 검사
+    {TASK_DISPATCH_PERIOD_MS, 0, dispatch_task},    // 4~5. 작업 큐 + 상태머신
+    {TASK_DISPLAY_PERIOD_MS, 0, update_display},    // 6. LED 및 디스플레이 업데이트
+};
 
 int main(void)
 {
@@ -66,166 +116,23 @@ int main(void)
 
   while (1)
   {
-<<<<<<< HEAD
-    swinput = ic165_read();
-
-    // 카 내부 1층 버튼
-    if (!(swinput & (1 << SW_CAR_1F_BIT)))
-    {
-      state = 7;
-    }
-    // 카 내부 4층 버튼
-    else if (!(swinput & (1 << SW_CAR_4F_BIT)))
-    {
-      state = 3;
-    }
-    // 외부 2층 호출 (UP)
-    else if (!(swinput & (1 << SW_CALL_2F_UP_BIT)))
-    {
-      state = 1;
-    }
-    // 카 내부 문 닫힘 버튼
-    else if (!(swinput & (1 << SW_CAR_CLOSE_BIT)))
-    {
-      while (loadcell_is_overload())
-      {
-        ic595_fndset(10);
-        ic595_update();
-        _delay_ms(500);
-        ic595_fndset(2);
-        ic595_update();
-        _delay_ms(500);
-      }
-      if (state == 3) state = 4;
-    }
-    // 카 내부 문 열림 버튼
-    else if (!(swinput & (1 << SW_CAR_OPEN_BIT)))
-    {
-      if (state == 12) state++;
-    }
-    else if ((swinput & (1 << SW_CAR_OPEN_BIT)))
-    {
-      if (state == 13) state++;
-    }
-    // 아무 버튼도 눌리지 않았을 경우
-    else
-    {
-    }
-
-    switch (state)
-    {
-    case 0:
-      ic595_fndset(1);
-      break;
-    case 1:
-      ic595_ledset(LED_CALL_2F_UP_BIT, 1);
-      ic595_ledset(LED_LNT_2F_UP_BIT, 1);
-      ic595_update();
-      stepper_move_to_floor(2, 1);
-      ic595_fndset(2);
-      ic595_update();
-      state = 2;
-      break;
-    case 2:
-      ic595_ledset(LED_CAR_LIGHT_BIT, 1);
-      ic595_ledset(LED_LNT_2F_UP_BIT, 0);
-      ic595_ledset(LED_CALL_2F_UP_BIT, 0);
-      ic595_update();
-      servo_door_open();
-      break;
-    case 3:
-      ic595_ledset(LED_CAR_4F_BIT, 1);
-      ic595_update();
-      break;
-    case 4:
-      ic595_ledset(LED_CAR_CLOSE_BIT, 1);
-      ic595_update();
-      servo_door_close();
-      ic595_ledset(LED_CAR_CLOSE_BIT, 0);
-      state = 5;
-      break;
-    case 5:
-      ic595_ledset(LED_LNT_4F_UP_BIT, 1);
-      ic595_update();
-      stepper_move_to_floor(3, 2);
-      ic595_fndset(3);
-      ic595_update();
-      stepper_move_to_floor(4, 3);
-      ic595_fndset(4);
-      ic595_update();
-      state = 6;
-      ic595_ledset(LED_CAR_4F_BIT, 0);
-      ic595_ledset(LED_LNT_4F_UP_BIT, 0);
-      ic595_update();
-      break;
-    case 6:
-      servo_door_open();
-      break;
-    case 7:
-      ic595_ledset(LED_CAR_1F_BIT, 1);
-      ic595_update();
-      _delay_ms(2000);
-      state = 8;
-      break;
-    case 8:
-      servo_door_close();
-      break;
-    case 9:
-      servo_door_open();
-      _delay_ms(2000);
-      state = 10;
-      break;
-    case 10:
-      servo_door_close();
-      state = 11;
-      break;
-    case 11:
-      ic595_ledset(LED_LNT_1F_DOWN_BIT, 1);
-      ic595_update();
-      stepper_move_to_floor(3, 4);
-      ic595_fndset(3);
-      ic595_update();
-      stepper_move_to_floor(2, 3);
-      ic595_fndset(2);
-      ic595_update();
-      stepper_move_to_floor(1, 2);
-      ic595_fndset(1);
-      ic595_update();
-      state = 12;
-      break;
-    case 12:
-      ic595_ledset(LED_CAR_1F_BIT, 0);
-      ic595_ledset(LED_LNT_1F_DOWN_BIT, 0);
-      ic595_update();
-      servo_door_open();
-      break;
-    case 13:
-      ic595_ledset(LED_CAR_OPEN_BIT, 1);
-      ic595_update();
-      break;
-    case 14:
-      ic595_ledset(LED_CAR_OPEN_BIT, 0);
-      ic595_update();
-      servo_door_close();
-      _delay_ms(2000);
-      ic595_ledset(LED_CAR_LIGHT_BIT, 0);
-      ic595_update();
-      break;
-    }
-
-    ic595_update();
-=======
-    // 0. 운영 모드 감지
-    check_operation_mode();
-
-    // 1. 안전 검사
-    safety_check();
+    // ISR이 넣은 이벤트를 먼저 처리하고, 주기가 된 태스크 실행 후 다음 인터럽트까지 슬립
+    process_events();
+    sched_dispatch(tasks, sizeof(tasks) / sizeof(tasks[0]));
+    sched_idle();
+  }
+}
 
-    // 2. 작업 큐 처리
-    process_task_queue();
+// =================================================================================
+// 작업 큐 + 상태머신 태스크
+// =================================================================================
+void dispatch_task()
+{
+  // 작업 큐 처리
+  process_task_queue();
 
-    // 3. 상태머신 처리
-    switch (ev_state)
+  // 상태머신 처리
+  switch (ev_state)
     {
     case ST_IDLE:
       handle_idle_state();
@@ -247,78 +154,263 @@ int main(void)
       handle_door_closing_state();
       break;
     }
+}
+
+// =================================================================================
+// 이벤트 처리 (ISR -> 메인 루프)
+// =================================================================================
+void process_events()
+{
+  event_t ev;
+  uint8_t rx;
 
-    // 4. LED 및 디스플레이 업데이트
-    update_display();
+  // 로드셀 변환 완료 시 읽기 + 필터 (핀 변화 인터럽트는 플래그만 세움)
+  loadcell_poll();
 
-    // 5. 시스템 틱 (50ms 주기)
->>>>>>> 1f27fee4a23132facf9a3edd74fd4b5bf8e1d406
-    _delay_ms(50);
+  // 카 간 통신 수신 바이트
+  while (uart_rx_read(&rx))
+  {
+    handle_uart_event(rx);
+  }
+
+  while (event_pop(&ev))
+  {
+    switch (ev.type)
+    {
+    case EVT_HOME:
+      // 위치 보정은 PCINT1_vect에서 이미 완료됨
+      break;
+
+    case EVT_DOOR_OBSTACLE:
+      // 문 닫기 중에만 장애물 감지 처리 (열림 완료 시 유지 타이머 재시작)
+      if (ev_state == ST_DOOR_CLOSING)
+      {
+        start_door_opening();
+      }
+      break;
+    }
+  }
+}
+
+// 버튼 샘플링 태스크 (디바운스 후 새로 눌린 버튼만 처리)
+// 165 읽기는 595 출력 래치와 한 번의 SPI 버스트로 수행 (바뀐 LED도 함께 반영됨)
+void switch_task()
+{
+  uint8_t sample[IC165_CHAIN_BYTES];
+  ic595_exchange(sample);
+  ic165_scan(sample);
+
+  uint8_t pressed[IC165_CHAIN_BYTES];
+  if (ic165_get_press(pressed)) handle_switch_event(pressed);
+}
+
+// 버튼 처리 (pressed: 이번에 새로 눌린 스위치 바이트 배열, Active High)
+void handle_switch_event(const uint8_t *pressed)
+{
+  // 눌림 에지마다 한 번만 호출되므로 누르고 있는 버튼이 다시 등록되지 않음
+  // LED는 출력 버퍼만 바꾸고, 실제 전송은 update_display()에서 틱마다 한 번 수행
+  // 스위치/LED 비트 배치는 building.h 참고
+
+  // 카 내부 버튼들
+  // 열림 버튼은 이동 중에는 무시 (도착하면 열림)
+  if (IC165_BIT(pressed, SW_CAR_OPEN_BIT) && ev_state != ST_MOVING && !stepper_is_busy())
+  {
+    start_door_opening();
+    // 문 열기 버튼 LED 켜기
+    ic595_ledset(LED_CAR_OPEN_BIT, 1);
+  }
+  if (IC165_BIT(pressed, SW_CAR_CLOSE_BIT))
+  {
+    if (ev_state != ST_DOOR_OPENED) return;
+    start_door_closing();
+    // 문 닫기 버튼 LED 켜기
+    ic595_ledset(LED_CAR_CLOSE_BIT, 1);
+    return;
+  }
+  for (uint8_t floor = 1; floor <= FLOOR_COUNT; floor++)
+  {
+    if (!IC165_BIT(pressed, SW_CAR_FLOOR_BIT(floor))) continue;
+
+    // 이동 중에는 이미 멈출 수 없는 층(다음 정지 가능 층 뒤쪽)만 받지 않음
+    if (ev_current_dir == DIR_ASCENDING && floor < ev_next_stop_floor) continue;
+    if (ev_current_dir == DIR_DESCENDING && floor > ev_next_stop_floor) continue;
+
+    // 카 호출 등록 (이미 등록된 층이면 그대로) 및 층 버튼 LED 켜기
+    calls_add_car(floor);
+    ic595_ledset(LED_CAR_FLOOR_BIT(floor), 1);
+  }
+  if (IC165_BIT(pressed, SW_CAR_BELL_BIT))
+  {
+    // 벨 버튼 LED 켜기
+    ic595_ledset(LED_CAR_BELL_BIT, 1);
+    set_bell_led_timer(); // 벨 LED 타이머 설정
+  }
+
+  // 외부 호출 버튼들 (버튼 순번 = 층 순서, 같은 층은 상행 -> 하행)
+  for (uint8_t index = 0; index < HALL_CALL_COUNT; index++)
+  {
+    if (!IC165_BIT(pressed, SW_CALL_BIT(index))) continue;
+
+    uint8_t floor = building_hall_floor(index);
+    uint8_t dir = building_hall_dir(index);
+
+    // 호출 LED 켜기
+    ic595_ledset(LED_CALL_BIT(index), 1);
+    handle_external_call(floor, dir); // 단독/군 운영 자동 처리
+  }
+}
+
+// UART 수신 바이트 처리 (프레임이 완성되면 처리)
+void handle_uart_event(uint8_t rxbuf)
+{
+  if (link_rx_byte(rxbuf, &rx_frame))
+  {
+    handle_link_frame(&rx_frame);
+  }
+}
+
+// 카 간 통신 프레임 처리
+void handle_link_frame(link_frame_t *frame)
+{
+  switch (frame->type)
+  {
+  case LINK_MSG_STATE:
+  {
+    car_state_t state;
+    if (frame->len != sizeof(state)) break;
+    memcpy(&state, frame->payload, sizeof(state));
+    if (state.car_id == CAR_ID || state.car_id >= LINK_MAX_CARS) break; // 에코/잘못된 번호 무시
+
+    // 상태를 받은 카는 군 테이블에서 살아 있는 카로 갱신
+    group_update(&state);
+    operation_mode = group_count();
+
+    // 넘긴 호출이 다른 카 상태에 나타나도 확인 완료 (ACK 손실 대비)
+    floor_mask_t up, down;
+    group_hall_calls(&up, &down);
+    handoff_up &= ~up;
+    handoff_down &= ~down;
+    sync_hall_lamps();
+    break;
+  }
+
+  case LINK_MSG_ASSIGN:
+  {
+    link_assign_t assign;
+    if (frame->len != sizeof(assign)) break;
+    memcpy(&assign, frame->payload, sizeof(assign));
+
+    // 없는 방향이나 그 층에 없는 홀 버튼(최상층 상행 등)이면 버림
+    if (assign.dir != DIR_ASCENDING && assign.dir != DIR_DESCENDING) break;
+    if (building_hall_index(assign.floor, assign.dir) == HALL_CALL_NONE) break;
+
+    // 다른 카가 이 카에 배정한 홀 호출
+    // 바로 처리해 상태 방송에 나타나지 않을 수 있으므로 배정한 카에게 수락을 따로 알림
+    calls_add_hall(assign.floor, assign.dir);
+    set_call_button_led(assign.floor, assign.dir, 1);
+    link_send(frame->src, LINK_MSG_ASSIGN_ACK, &assign, sizeof(assign));
+    break;
+  }
+
+  case LINK_MSG_ASSIGN_ACK:
+  {
+    link_assign_t assign;
+    if (frame->len != sizeof(assign)) break;
+    memcpy(&assign, frame->payload, sizeof(assign));
+    if (building_hall_index(assign.floor, assign.dir) == HALL_CALL_NONE) break;
+
+    // 넘긴 호출을 받은 카가 맡음: 이후 홀 LED는 그 카의 상태 방송을 따름
+    if (assign.dir == DIR_ASCENDING)
+      handoff_up &= ~FLOOR_BIT(assign.floor);
+    else
+      handoff_down &= ~FLOOR_BIT(assign.floor);
+    sync_hall_lamps();
+    break;
+  }
+  }
+}
+
+// 상태 방송 태스크 (단독 운영 중에도 보내야 다른 카들이 이 카를 발견함)
+void broadcast_state()
+{
+  car_state_t me;
+  get_car_state(&me);
+  link_send(LINK_BROADCAST, LINK_MSG_STATE, &me, sizeof(me));
+}
+
+// 이 카의 현재 상태 스냅샷
+void get_car_state(car_state_t *car)
+{
+  int32_t load = loadcell_get_weight_g();
+
+  car->car_id = CAR_ID;
+  car->position = (int16_t)stepper_get_position();
+  car->floor = ev_current_floor;
+  car->next_stop = ev_next_stop_floor;
+  car->state = ev_state;
+  car->motion_dir = ev_current_dir;
+  car->travel_dir = ev_travel_dir;
+  calls_get(&car->car_calls, &car->up_calls, &car->down_calls);
+  car->load_g = (load > INT16_MAX) ? INT16_MAX : (load < INT16_MIN) ? INT16_MIN : (int16_t)load;
+  car->flags = (loadcell_is_overload() ? CAR_FLAG_OVERLOAD : 0) | (emergency_flag ? CAR_FLAG_EMERGENCY : 0);
+  car->floor_ms = eta_floor_ms();
+  car->door_ms = (ev_state == ST_DOOR_OPENED) ? timer_remaining(TMR_DOOR_HOLD) : 0;
+}
+
+// 홀 호출 LED = 이 카의 호출 | 다른 카들의 호출 | 넘기는 중인 호출
+void sync_hall_lamps()
+{
+  floor_mask_t car, up, down, group_up, group_down;
+  calls_get(&car, &up, &down);
+  group_hall_calls(&group_up, &group_down);
+  up |= handoff_up | group_up;
+  down |= handoff_down | group_down;
+
+  for (uint8_t floor = 1; floor <= FLOOR_COUNT; floor++)
+  {
+    set_call_button_led(floor, DIR_ASCENDING, (up & FLOOR_BIT(floor)) != 0);
+    set_call_button_led(floor, DIR_DESCENDING, (down & FLOOR_BIT(floor)) != 0);
+  }
+}
+
+// 홀 호출 비트맵을 이 카의 호출로 등록
+void take_over_calls(floor_mask_t up, floor_mask_t down)
+{
+  for (uint8_t floor = 1; floor <= FLOOR_COUNT; floor++)
+  {
+    if (up & FLOOR_BIT(floor)) calls_add_hall(floor, DIR_ASCENDING);
+    if (down & FLOOR_BIT(floor)) calls_add_hall(floor, DIR_DESCENDING);
   }
 }
 
 void init()
 {
-  // 시프트 레지스터 제어핀 설정
-  RCLK_595_DDR |= (1 << RCLK_595_PIN);
-  SER_595_DDR |= (1 << SER_595_PIN);
-  SRCLK_DDR |= (1 << SRCLK_PIN);
-  CP_LATCH_165_DDR |= (1 << CP_LATCH_165_PIN);
-  MISO_165_DDR &= ~(1 << MISO_165_PIN); // MISO는 입력
+  // 시프트 레지스터 SPI, 165 Load/595 래치 핀 설정
+  hal_spi_init();
 
-  // 리미트 스위치 핀 입력으로 설정 (PC3: Home, PC4: Door Closed만 사용)
-  // 외부 풀업 저항이 있으므로, 내부 풀업(PORTC) 설정은 하지 않음
-  LS_HOME_DDR &= ~(1 << LS_HOME_PIN);
-  LS_DOOR_CLOSED_DDR &= ~(1 << LS_DOOR_CLOSED_PIN);
+  // 리미트 스위치 입력 (Home, Door Closed)과 핀 변화 인터럽트 설정
+  hal_inputs_init();
 
   // 모든 모듈 초기화
+  building_init(); // 홀 버튼 순번 표 (LED/스위치 배치)
+  calls_init();
   stepper_init();
   servo_init();
   loadcell_init();
-  uart_init(31250); // 31.25kbps
+  uart_init(UART_BAUD); // 250kbps
+  sched_init();     // Timer0 1ms 틱
 
-<<<<<<< HEAD
-  // 서보모터 PWM 핀 출력 설정
-  SERVO_DDR |= (1 << SERVO_PIN);
-  servo_init();
+  // 버튼은 switch_task()가 5ms마다 74HC165를 샘플링 (핀 변화 인터럽트 미사용)
 
-  // HX711 로드셀 핀 설정
-  HX711_DT_DDR &= ~(1 << HX711_DT_PIN);  // DT 입력
-  HX711_SCK_DDR |= (1 << HX711_SCK_PIN); // SCK 출력
-  loadcell_init();
-  loadcell_tare();
-=======
-  // 인터럽트 설정
-  // PCINT1: PC3(Home), PC4(Door Closed) 인터럽트 활성화
-  PCICR |= (1 << PCIE1);
-  PCMSK1 |= (1 << PCINT11) | (1 << PCINT12); // PC3 = PCINT11, PC4 = PCINT12
-
-  // PCINT2: PD5 스위치 인터럽트 활성화 (다이오드 OR 게이트 출력)
-  PCICR |= (1 << PCIE2);
-  PCMSK2 |= (1 << PCINT21); // PD5 = PCINT21
->>>>>>> 1f27fee4a23132facf9a3edd74fd4b5bf8e1d406
-
-  // PD5를 입력으로 설정 (외부 풀업 저항 사용)
-  DDRD &= ~(1 << PD5);  // PD5를 입력으로 설정
-  PORTD &= ~(1 << PD5); // 내부 풀업 비활성화 (외부 풀업 사용)
-
-<<<<<<< HEAD
-  // 인터럽트 초기화 필요?
-  PCMSK1 |= (1 << PCINT12);
-  PCICR |= (1 << PCIE1);
-  PCIFR |= (1 << PCIF1);
-  sei();
-=======
   // 전역 인터럽트 활성화
-  sei();
+  hal_irq_enable();
 
   // 모든 LED 초기화 (끄기)
   init_all_leds();
->>>>>>> 1f27fee4a23132facf9a3edd74fd4b5bf8e1d406
 
   // 초기 출력 상태 업데이트
   ic595_update();
-  _delay_ms(100);
+  hal_delay_ms(100);
 
   // 로드셀 영점 조정
   loadcell_tare();
@@ -345,7 +437,7 @@ void safety_check()
   {
     emergency_flag = 0;
     ev_state = ST_DOOR_OPENED; // 문 열림 상태로 복구
-    door_holding = 0;          // 타이머 리셋하여 문 열림 시간 연장
+    timer_start(TMR_DOOR_HOLD, DOOR_HOLD_MS); // 타이머 리셋하여 문 열림 시간 연장
   }
 }
 
@@ -357,6 +449,9 @@ void process_task_queue()
   // 비상 상태에서는 작업 처리 안 함
   if (emergency_flag) return;
 
+  // 문이 완전히 닫히기 전에는 출발하지 않음
+  if (servo_door_busy()) return;
+
   // 대기 상태이고 작업이 있으면 다음 작업 시작
   if (ev_state == ST_IDLE)
   {
@@ -373,33 +468,11 @@ void process_task_queue()
 // =================================================================================
 void handle_idle_state()
 {
-  // 현재 층에 중지 요청이 있는지 확인
-  for (uint8_t i = 0; i < 5; i++)
+  // 현재 층에 멈춰야 할 호출이 있으면 처리 후 문 열기
+  if (stop_kinds_at(ev_current_floor))
   {
-    if (task_queue[i] != 0)
-    {
-      // uart.c 인코딩 방식에 맞게 수정
-      uint8_t floor = (task_queue[i] >> UART_FLOOR_BIT) & 0b11;         // 비트 0-1: 층
-      uint8_t direction = (task_queue[i] >> UART_DIRECTION_BIT) & 0b11; // 비트 2-3: 방향
-      if (floor == ev_current_floor)
-      {
-        // 현재 층에 도착 - 관련 LED 끄기
-        turn_off_car_button_led(floor);
-        turn_off_call_button_led(floor, direction);
-
-        // 문 열기
-        ev_state = ST_DOOR_OPENING;
-        door_holding = 0;
-
-        // 완료된 작업 제거
-        for (uint8_t j = i; j < 4; j++)
-        {
-          task_queue[j] = task_queue[j + 1];
-        }
-        task_queue[4] = 0;
-        break;
-      }
-    }
+    serve_stop(ev_current_floor);
+    start_door_opening();
   }
 }
 
@@ -408,15 +481,25 @@ void handle_idle_state()
 // =================================================================================
 void handle_moving_state()
 {
-  moving_timer++;
-
-  // 이동 시간 초과 감지 (30초 = 600 * 50ms)
-  if (moving_timer > 600)
+  // 이동 시간 초과 감지 (층 경계 사이 12초)
+  if (timer_fired(TMR_MOVING))
   {
     emergency_stop();
     return;
   }
 
+  // 스텝모터 위치로부터 현재 층과 다음 정지 가능 층 갱신 (층 경계를 지날 때마다 바뀜)
+  uint8_t floor = stepper_get_floor();
+  if (floor != ev_current_floor)
+  {
+    timer_start(TMR_MOVING, MOVING_TIMEOUT_PER_FLOOR_MS); // 층 경계를 지나면 한 층 분량으로 재시작
+  }
+  ev_current_floor = floor;
+  ev_next_stop_floor = stepper_next_stop_floor();
+
+  // 이동 중 등록된 호출을 반영해 목표 층 변경
+  update_moving_target();
+
   // 층 도달 확인
   check_floor_arrival();
 }
@@ -426,9 +509,13 @@ void handle_moving_state()
 // =================================================================================
 void handle_door_opening_state()
 {
-  // 서보모터로 문 열기
-  servo_door_open();
-  ev_state = ST_DOOR_OPENED;
+  // 서보 이동은 start_door_opening()에서 한 번만 시작, 여기서는 완료만 확인
+  // 문이 다 열리면 열림 상태로 전환
+  if (!servo_door_busy())
+  {
+    ev_state = ST_DOOR_OPENED;
+    timer_start(TMR_DOOR_HOLD, DOOR_HOLD_MS);
+  }
 }
 
 // =================================================================================
@@ -436,20 +523,17 @@ void handle_door_opening_state()
 // =================================================================================
 void handle_door_opened_state()
 {
-  door_holding++;
-
   // 과적 상태에서는 문 닫기 금지
   if (emergency_flag || loadcell_is_overload())
   {
-    door_holding = 0; // 타이머 리셋하여 계속 열어둠
+    timer_start(TMR_DOOR_HOLD, DOOR_HOLD_MS); // 타이머 리셋하여 계속 열어둠
     return;
   }
 
-  // 문 열림 유지 시간 초과 (DOOR_HOLD_TIME = 1000 * 50ms = 50초)
-  if (door_holding >= DOOR_HOLD_TIME)
+  // 문 열림 유지 시간 초과 (DOOR_HOLD_MS = 50초)
+  if (!timer_running(TMR_DOOR_HOLD))
   {
-    ev_state = ST_DOOR_CLOSING;
-    door_holding = 0;
+    start_door_closing();
   }
 }
 
@@ -458,8 +542,12 @@ void handle_door_opened_state()
 // =================================================================================
 void handle_door_closing_state()
 {
-  // 서보모터로 문 닫기
-  servo_door_close();
+  // 서보 이동은 start_door_closing()에서 한 번만 시작, 여기서는 완료만 확인
+  // 문이 다 닫히면 대기 상태로 전환
+  if (!servo_door_busy())
+  {
+    ev_state = ST_IDLE;
+  }
 }
 
 // =================================================================================
@@ -471,22 +559,16 @@ void update_display()
 
   // 방향 LED 표시 (홀 랜턴)
   // 먼저 모든 방향 LED 끄기
-  for (uint8_t i = LED_LNT_1F_UP_BIT; i <= LED_LNT_4F_DOWN_BIT; i++)
+  for (uint8_t i = LED_LNT_BIT(1, DIR_ASCENDING); i <= LED_LNT_BIT(FLOOR_COUNT, DIR_DESCENDING); i++)
   {
     ic595_ledset(i, 0);
   }
 
   // 이동 중일 때만 방향 LED 켜기
-  if (ev_state == ST_MOVING)
+  if (ev_state == ST_MOVING && ev_current_floor >= 1 && ev_current_floor <= FLOOR_COUNT &&
+      (ev_current_dir == DIR_ASCENDING || ev_current_dir == DIR_DESCENDING))
   {
-    if (ev_current_dir == DIR_ASCENDING && ev_current_floor <= 4)
-    {
-      ic595_ledset(LED_LNT_1F_UP_BIT + (ev_current_floor - 1) * 2, 1);
-    }
-    else if (ev_current_dir == DIR_DESCENDING && ev_current_floor >= 1)
-    {
-      ic595_ledset(LED_LNT_1F_DOWN_BIT + (ev_current_floor - 1) * 2, 1);
-    }
+    ic595_ledset(LED_LNT_BIT(ev_current_floor, ev_current_dir), 1);
   }
 
   // 문 상태 LED - 상태에 따라 자동 제어
@@ -527,18 +609,12 @@ void update_display()
   if (emergency_flag || (ev_state == ST_DOOR_OPENED && loadcell_is_overload()))
   {
     ic595_ledset(LED_CAR_BELL_BIT, (system_timer % 4 < 2) ? 1 : 0);
-    bell_led_timer_global = 0; // 비상 상태에서는 일반 타이머 리셋
+    timer_stop(TMR_BELL); // 비상 상태에서는 일반 타이머 리셋
   }
   // 일반 상태에서 벨 버튼을 눌렀을 때 (3초간 점멸 후 꺼짐)
-  else if (bell_led_timer_global > 0)
+  else if (timer_running(TMR_BELL))
   {
-    bell_led_timer_global--;
-    // 3초간 점멸 (60 * 50ms)
     ic595_ledset(LED_CAR_BELL_BIT, (system_timer % 6 < 3) ? 1 : 0);
-    if (bell_led_timer_global == 0)
-    {
-      ic595_ledset(LED_CAR_BELL_BIT, 0); // 완전히 끄기
-    }
   }
   // 아무것도 없을 때는 끄기
   else
@@ -569,23 +645,19 @@ void update_display()
     }
     else
     {
-      // 2대 운영: 층 번호에 점 추가 (시각적 구분)
+      // 군 운영: 층 번호에 점 추가 (시각적 구분)
       ic595_fndset(ev_current_floor);
-      // 추가적인 LED로 2대 운영 모드 표시 가능 (선택적)
+      // 추가적인 LED로 군 운영 모드 표시 가능 (선택적)
     }
   }
 
   // 조명 자동 제어 (3초 후 소등)
-  if (g_light_timer_count > 0)
+  if (timer_fired(TMR_LIGHT))
   {
-    g_light_timer_count--;
-    if (g_light_timer_count == 0)
-    {
-      ic595_ledset(LED_CAR_LIGHT_BIT, 0);
-    }
+    ic595_ledset(LED_CAR_LIGHT_BIT, 0);
   }
 
-  // 출력 업데이트
+  // 출력 업데이트 (이번 틱 동안 ISR/메인에서 바뀐 LED를 한 번에 반영, 변경 없으면 생략)
   ic595_update();
 }
 
@@ -593,100 +665,168 @@ void update_display()
 // 헬퍼 함수들
 // =================================================================================
 
-// 다음 작업 가져오기 (우선순위 기반)
+// 다음 정지 층 결정 (LOOK 집합 운행)
+// 운행 방향 앞쪽에 호출이 남아 있는 동안 그 방향의 가장 가까운 정지 층으로 가고,
+// 앞쪽에 아무 호출도 없을 때만 방향을 바꿈
 uint8_t get_next_task()
 {
-  uint8_t best_floor = 0;
-  int8_t best_distance = 127; // 최대 거리
-  uint8_t best_index = 0;
+  uint8_t floor = ev_current_floor;
 
-  for (uint8_t i = 0; i < 5; i++)
+  if (!calls_all())
   {
-    if (task_queue[i] != 0)
-    {
-      // uart.c 인코딩 방식에 맞게 수정
-      uint8_t floor = (task_queue[i] >> UART_FLOOR_BIT) & 0b11;   // 비트 0-1: 층
-      uint8_t dir = (task_queue[i] >> UART_DIRECTION_BIT) & 0b11; // 비트 2-3: 방향
+    ev_travel_dir = DIR_IDLE;
+    return 0;
+  }
 
-      // 거리 계산
-      int8_t distance = abs((int8_t)floor - (int8_t)ev_current_floor);
+  // 현재 층에서 처리할 호출이 있으면 출발하지 않음 (handle_idle_state()가 문을 엶)
+  if (stop_kinds_at(floor)) return floor;
 
-      // 방향 일치 시 우선순위 높음
-      if (ev_current_dir != DIR_IDLE)
-      {
-        if ((ev_current_dir == DIR_ASCENDING && floor > ev_current_floor && dir == DIR_ASCENDING) ||
-            (ev_current_dir == DIR_DESCENDING && floor < ev_current_floor && dir == DIR_DESCENDING))
-        {
-          distance -= 10; // 보너스
-        }
-      }
+  // 정지 중이었다면 가장 가까운 호출 쪽으로 출발 (같으면 상행)
+  if (ev_travel_dir == DIR_IDLE)
+  {
+    uint8_t above = next_stop_ahead(floor, DIR_ASCENDING);
+    uint8_t below = next_stop_ahead(floor, DIR_DESCENDING);
+    if (above && (!below || above - floor <= floor - below))
+      ev_travel_dir = DIR_ASCENDING;
+    else
+      ev_travel_dir = DIR_DESCENDING;
+  }
 
-      if (distance < best_distance)
-      {
-        best_distance = distance;
-        best_floor = floor;
-        best_index = i;
-      }
-    }
+  uint8_t next = next_stop_ahead(floor, ev_travel_dir);
+  if (!next)
+  {
+    // 앞쪽에 호출이 없으면 반전
+    ev_travel_dir = (ev_travel_dir == DIR_ASCENDING) ? DIR_DESCENDING : DIR_ASCENDING;
+    next = next_stop_ahead(floor, ev_travel_dir);
   }
 
-  // 선택된 작업 제거
-  if (best_floor != 0)
+  // 호출은 해당 층에 도착해 문을 열 때 serve_stop()에서 지움
+  return next;
+}
+
+// from층에서 dir 방향으로 가면서 처음 멈출 층 (없으면 0)
+// 카 호출이나 같은 방향 홀 호출이 있는 층에서 멈추고,
+// 반대 방향 홀 호출은 그 너머에 호출이 없을 때(반전 지점)만 멈춤
+uint8_t next_stop_ahead(uint8_t from, uint8_t dir)
+{
+  uint8_t same = (dir == DIR_ASCENDING) ? CALLS_UP : CALLS_DOWN;
+  int8_t step = (dir == DIR_ASCENDING) ? 1 : -1;
+
+  for (int8_t f = (int8_t)from + step; f >= 1 && f <= FLOOR_COUNT; f += step)
   {
-    for (uint8_t j = best_index; j < 4; j++)
-    {
-      task_queue[j] = task_queue[j + 1];
-    }
-    task_queue[4] = 0;
+    uint8_t kinds = calls_at(f);
+    if (!kinds) continue;
+
+    if (kinds & (CALLS_CAR | same)) return f;
+
+    floor_mask_t beyond = (dir == DIR_ASCENDING) ? calls_above(f) : calls_below(f);
+    if (!beyond) return f;
   }
+  return 0;
+}
+
+// 현재 운행 방향으로 floor층에 멈췄을 때 처리할 호출 종류
+uint8_t stop_kinds_at(uint8_t floor)
+{
+  uint8_t kinds = calls_at(floor);
+
+  // 앞쪽에 호출이 남아 있으면 반대 방향 홀 호출은 돌아올 때 처리
+  if (ev_travel_dir == DIR_ASCENDING && calls_above(floor))
+    return kinds & (CALLS_CAR | CALLS_UP);
+  if (ev_travel_dir == DIR_DESCENDING && calls_below(floor))
+    return kinds & (CALLS_CAR | CALLS_DOWN);
 
-  return best_floor;
+  return kinds;
+}
+
+// floor층 정지 처리: 해당 호출을 지우고, 반대 방향 홀 호출을 태웠으면 운행 방향 반전
+void serve_stop(uint8_t floor)
+{
+  uint8_t kinds = stop_kinds_at(floor);
+
+  if (ev_travel_dir == DIR_ASCENDING && (kinds & CALLS_DOWN) && !(kinds & CALLS_UP))
+    ev_travel_dir = DIR_DESCENDING;
+  else if (ev_travel_dir == DIR_DESCENDING && (kinds & CALLS_UP) && !(kinds & CALLS_DOWN))
+    ev_travel_dir = DIR_ASCENDING;
+  else if (ev_travel_dir == DIR_IDLE && (kinds & (CALLS_UP | CALLS_DOWN)))
+    ev_travel_dir = (kinds & CALLS_UP) ? DIR_ASCENDING : DIR_DESCENDING;
+
+  serve_floor(floor, kinds);
 }
 
 // 층 이동 시작
 void start_moving_to_floor(uint8_t target_floor_param)
 {
-  if (target_floor_param < 1 || target_floor_param > 4) return;
+  if (target_floor_param < 1 || target_floor_param > FLOOR_COUNT) return;
 
   target_floor = target_floor_param;
-  moving_timer = 0;
   ev_state = ST_MOVING;
+  trip_start_ms = sched_millis();
+  trip_start_floor = ev_current_floor;
 
   // 방향 결정
-  if (target_floor > ev_current_floor)
-  {
-    ev_current_dir = DIR_ASCENDING;
-  }
-  else
-  {
-    ev_current_dir = DIR_DESCENDING;
-  }
+  ev_current_dir = (target_floor > ev_current_floor) ? DIR_ASCENDING : DIR_DESCENDING;
 
-  // 스텝모터로 이동 시작
+  // 이동 시간 감시는 층 단위 (handle_moving_state()에서 층 경계마다 재시작)
+  timer_start(TMR_MOVING, MOVING_TIMEOUT_PER_FLOOR_MS);
+
+  // 스텝모터로 이동 시작 (Timer2가 백그라운드에서 구동, handle_moving_state()에서 완료 확인)
   stepper_move_to_floor(target_floor, ev_current_floor);
 
   // 조명 켜기
   ic595_ledset(LED_CAR_LIGHT_BIT, 1);
-  g_light_timer_count = 60; // 3초 (60 * 50ms)
+  timer_start(TMR_LIGHT, LIGHT_ON_MS);
 }
 
-// 층 도달 확인
-void check_floor_arrival()
+// 문 열기 시작 (닫히는 도중이면 그 자리에서 반전)
+void start_door_opening()
+{
+  ev_state = ST_DOOR_OPENING;
+  servo_door_open();
+}
+
+// 문 닫기 시작
+void start_door_closing()
+{
+  ev_state = ST_DOOR_CLOSING;
+  servo_door_close();
+}
+
+// 이동 중 목표 변경 (아직 멈출 수 있는 층부터 LOOK 정지 층을 다시 찾음)
+// 지나가려던 층에 새 호출이 생기면 목표를 당기고, 반전 지점 너머에 호출이 생기면 목표를 늘림
+void update_moving_target()
 {
-  // 리미트 스위치로 확인 (홈 위치에서만)
-  if (!(LS_HOME_PIN_REG & (1 << LS_HOME_PIN)))
+  if (!stepper_is_busy()) return; // 이미 도착: check_floor_arrival()에서 처리
+
+  int8_t step = (ev_current_dir == DIR_ASCENDING) ? 1 : -1;
+  uint8_t next = next_stop_ahead((int8_t)ev_next_stop_floor - step, ev_current_dir);
+
+  if (next == 0 || next == target_floor) return;
+
+  // 감속 거리가 부족하면 스텝모터가 거절하고 기존 목표 유지
+  if (stepper_retarget_floor(next))
   {
-    ev_current_floor = 1;
-    stepper_reset_position();
+    target_floor = next;
   }
+}
 
-  // 목표 층 도달 확인
-  if (ev_current_floor == target_floor)
-  {
-    ev_state = ST_DOOR_OPENING;
+// 층 도달 확인
+void check_floor_arrival()
+{
+  // 홈 리미트 스위치 위치 보정은 PCINT1_vect에서 눌리는 순간에만 수행
+  // (여기서 레벨을 보면 1층을 떠나는 동안 위치가 계속 0으로 되돌아감)
+
+  // 목표 층 도달 확인 (스텝모터가 목표 위치에 도착하여 정지)
+  if (!stepper_is_busy())
+  {
+    ev_current_floor = target_floor;
+    ev_next_stop_floor = target_floor;
+    eta_learn_trip((target_floor > trip_start_floor) ? target_floor - trip_start_floor : trip_start_floor - target_floor,
+                   sched_millis() - trip_start_ms);
+    serve_stop(ev_current_floor);
+    start_door_opening();
     ev_current_dir = DIR_IDLE;
-    door_holding = 0;
-    moving_timer = 0;
+    timer_stop(TMR_MOVING);
     stepper_stop();
   }
 }
@@ -696,14 +836,12 @@ void emergency_stop()
 {
   ev_state = ST_IDLE;
   ev_current_dir = DIR_IDLE;
+  timer_stop(TMR_MOVING);
   stepper_stop();
   servo_door_close();
 
-  // 모든 LED 끄기
-  for (uint8_t i = 0; i < 32; i++)
-  {
-    ic595_ledset(i, 0);
-  }
+  // 모든 LED 끄기 (체인 전체)
+  ic595_clear();
 
   // 비상 LED만 켜기
   ic595_ledset(LED_CAR_BELL_BIT, 1);
@@ -717,59 +855,44 @@ void emergency_stop()
 // 카 내부 버튼 LED 끄기
 void turn_off_car_button_led(uint8_t floor)
 {
-  if (floor >= 1 && floor <= 4)
+  if (floor >= 1 && floor <= FLOOR_COUNT)
   {
-    ic595_ledset(LED_CAR_1F_BIT + floor - 1, 0);
+    ic595_ledset(LED_CAR_FLOOR_BIT(floor), 0);
   }
 }
 
 // 외부 호출 버튼 LED 끄기
 void turn_off_call_button_led(uint8_t floor, uint8_t direction)
 {
-  switch (floor)
-  {
-  case 1:
-    if (direction == DIR_ASCENDING)
-    {
-      ic595_ledset(LED_CALL_1F_UP_BIT, 0);
-    }
-    break;
-  case 2:
-    if (direction == DIR_ASCENDING)
-    {
-      ic595_ledset(LED_CALL_2F_UP_BIT, 0);
-    }
-    else if (direction == DIR_DESCENDING)
-    {
-      ic595_ledset(LED_CALL_2F_DOWN_BIT, 0);
-    }
-    break;
-  case 3:
-    if (direction == DIR_ASCENDING)
-    {
-      ic595_ledset(LED_CALL_3F_UP_BIT, 0);
-    }
-    else if (direction == DIR_DESCENDING)
-    {
-      ic595_ledset(LED_CALL_3F_DOWN_BIT, 0);
-    }
-    break;
-  case 4:
-    if (direction == DIR_DESCENDING)
-    {
-      ic595_ledset(LED_CALL_4F_DOWN_BIT, 0);
-    }
-    break;
-  }
+  set_call_button_led(floor, direction, 0);
+}
+
+// 외부 호출 버튼 LED 켜기/끄기 (해당 층에 없는 방향 버튼은 무시)
+void set_call_button_led(uint8_t floor, uint8_t direction, uint8_t state)
+{
+  uint8_t index = building_hall_index(floor, direction);
+  if (index == HALL_CALL_NONE) return;
+
+  ic595_ledset(LED_CALL_BIT(index), state);
+}
+
+// 층의 호출을 처리 완료로 지우고 해당 버튼 LED 끄기
+void serve_floor(uint8_t floor, uint8_t kinds)
+{
+  calls_clear(floor, kinds);
+
+  if (kinds & CALLS_CAR) turn_off_car_button_led(floor);
+  if (kinds & CALLS_UP) turn_off_call_button_led(floor, DIR_ASCENDING);
+  if (kinds & CALLS_DOWN) turn_off_call_button_led(floor, DIR_DESCENDING);
 }
 
 // 모든 LED 초기화 (끄기)
 void init_all_leds()
 {
   // 카 내부 버튼 LED 모두 끄기
-  for (uint8_t i = LED_CAR_1F_BIT; i <= LED_CAR_4F_BIT; i++)
+  for (uint8_t floor = 1; floor <= FLOOR_COUNT; floor++)
   {
-    ic595_ledset(i, 0);
+    ic595_ledset(LED_CAR_FLOOR_BIT(floor), 0);
   }
 
   // 문 제어 LED 끄기
@@ -780,67 +903,99 @@ void init_all_leds()
   ic595_ledset(LED_CAR_BELL_BIT, 0);
 
   // 외부 호출 LED 모두 끄기
-  ic595_ledset(LED_CALL_1F_UP_BIT, 0);
-  ic595_ledset(LED_CALL_2F_UP_BIT, 0);
-  ic595_ledset(LED_CALL_2F_DOWN_BIT, 0);
-  ic595_ledset(LED_CALL_3F_UP_BIT, 0);
-  ic595_ledset(LED_CALL_3F_DOWN_BIT, 0);
-  ic595_ledset(LED_CALL_4F_DOWN_BIT, 0);
+  for (uint8_t index = 0; index < HALL_CALL_COUNT; index++)
+  {
+    ic595_ledset(LED_CALL_BIT(index), 0);
+  }
 
   // 홀 랜턴 LED 모두 끄기
-  for (uint8_t i = LED_LNT_1F_UP_BIT; i <= LED_LNT_4F_DOWN_BIT; i++)
+  for (uint8_t i = LED_LNT_BIT(1, DIR_ASCENDING); i <= LED_LNT_BIT(FLOOR_COUNT, DIR_DESCENDING); i++)
   {
     ic595_ledset(i, 0);
   }
 }
 
-// 벨 LED 타이머 설정 (isr.c에서 호출 가능)
+// 벨 LED 타이머 설정
 void set_bell_led_timer()
 {
-  bell_led_timer_global = 60; // 3초 (60 * 50ms)
+  timer_start(TMR_BELL, BELL_BLINK_MS);
 }
 
 // =================================================================================
 // 운영 모드 관리 함수들
 // =================================================================================
 
-// 운영 모드 감지 (단독 vs 2대 운영)
+// 운영 모드 감지 (단독 vs 군 운영)
 void check_operation_mode()
 {
-  uart_timeout_counter++;
+  // 넘긴 호출의 수락이 제한 시간 안에 오지 않으면 (ASSIGN/ACK 손실) 직접 처리
+  if (timer_fired(TMR_HANDOFF))
+  {
+    take_over_calls(handoff_up, handoff_down);
+    handoff_up = 0;
+    handoff_down = 0;
+  }
+
+  // LINK_PEER_TIMEOUT_MS 동안 상태 프레임이 없던 카는 군 테이블에서 제외
+  uint8_t expired = group_expire();
+  if (expired == 0) return;
 
-  // 5초동안 UART 수신이 없으면 단독 모드
-  if (uart_timeout_counter > 100)
-  { // 100 * 50ms = 5초
-    if (operation_mode != 0)
+  operation_mode = group_count();
+
+  // 끊긴 카가 맡고 있던 홀 호출은 남은 카 중 번호가 가장 작은 카가 한 번만 인수
+  if (group_is_leader())
+  {
+    for (uint8_t id = 0; id < LINK_MAX_CARS; id++)
     {
-      operation_mode = 0; // 단독 모드
-      // 단독 모드 전환 메시지 (선택적)
+      if (!(expired & (1 << id))) continue;
+      const car_state_t *peer = group_peer(id);
+      take_over_calls(peer->up_calls, peer->down_calls);
     }
   }
-}
 
-// 외부 호출 처리 (단독/2대 대응)
-void handle_external_call(uint8_t floor, uint8_t direction)
-{
+  // 모두 끊기면 넘기는 중이던 호출도 직접 처리
   if (operation_mode == 0)
   {
-    // 단독 운영: 직접 자체 큐에 추가
-    enqueue(floor, direction);
+    take_over_calls(handoff_up, handoff_down);
+    handoff_up = 0;
+    handoff_down = 0;
   }
-  else
+  sync_hall_lamps();
+}
+
+// 외부 호출 처리 (단독/군 운영 대응)
+void handle_external_call(uint8_t floor, uint8_t direction)
+{
+  floor_mask_t bit = FLOOR_BIT(floor);
+  uint8_t kind = (direction == DIR_ASCENDING) ? CALLS_UP : CALLS_DOWN;
+
+  if (operation_mode != 0)
   {
-    // 2대 운영: UART 통신 + 상황에 따라 자체 처리
-    // 스코어 계산 및 전송
-    uint8_t my_score = 0;
-    for (uint8_t i = 0; i < 5; i++)
-    {
-      if (task_queue[i] != 0) my_score++;
-    }
+    // 이미 어느 한 카가 맡았거나 넘기는 중인 호출이면 무시 (ASSIGN 재전송/대기 시간 연장 방지)
+    floor_mask_t group_up, group_down;
+    group_hall_calls(&group_up, &group_down);
+    floor_mask_t group_calls = (direction == DIR_ASCENDING) ? group_up | handoff_up : group_down | handoff_down;
+    if ((calls_at(floor) & kind) || (group_calls & bit)) return;
 
-    uart_tx_data(my_score, ev_current_floor, ev_current_dir, 0);
+    // 군 운영: 최신 상태 테이블로 모든 카의 ETA를 계산해 가장 빠른 카에 배정 (같으면 번호가 작은 카)
+    car_state_t me;
+    get_car_state(&me);
+    uint8_t best = group_best_car(&me, floor, direction);
 
-    // 즐시 자체 큐에도 추가 (백업 처리)
-    enqueue(floor, direction);
+    if (best != CAR_ID)
+    {
+      link_assign_t assign = {floor, direction};
+      link_send(best, LINK_MSG_ASSIGN, &assign, sizeof(assign));
+
+      if (direction == DIR_ASCENDING)
+        handoff_up |= bit;
+      else
+        handoff_down |= bit;
+      timer_start(TMR_HANDOFF, LINK_HANDOFF_TIMEOUT_MS);
+      return;
+    }
   }
-}
\ No newline at end of file
+
+  // 단독 운영이거나 이 카가 가장 빠르면 직접 처리
+  calls_add_hall(floor, direction);
+}
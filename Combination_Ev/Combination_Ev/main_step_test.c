@@ -7,6 +7,7 @@
 #include "pinmacro.h"
 
 #include <stdint.h>
+#include <avr/interrupt.h>
 #include <avr/io.h>
 #include <util/delay.h>
 
@@ -19,6 +20,7 @@ int main(void)
 {
     // 스텝모터 초기화
     stepper_init();
+    sei(); // 스텝은 Timer2 인터럽트에서 생성됨
     
     _delay_ms(2000); // 초기화 대기
     
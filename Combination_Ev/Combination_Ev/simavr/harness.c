@@ -0,0 +1,689 @@
+/*
+ * harness.c - simavr cycle-accurate timing harness
+ * Runs the real ATmega328P build (main.c + src/, src/hal_avr.c backend) under
+ * simavr with a 74HC165 switch chain on SPI, an HX711 stand-in on PC0/PC1 and
+ * a UART peer that answers as car 1 on the RS-485 link. Stepping one
+ * instruction at a time, it records:
+ *   - per-vector ISR cycles (dispatch to RETI) and latency (flag raised to dispatch)
+ *   - interrupt-disabled windows (SREG I = 0), worst in main context and overall
+ *   - main-loop iterations (wake-up to next sleep, ISR cycles excluded)
+ *   - cycles per call of selected functions (ic595_update, ic595_exchange, servo_set_angle, ...)
+ * and exits non-zero when a limit in the budget file is exceeded.
+ *
+ *   harness [-t seconds] [-m firmware.map] [-b budgets.txt] firmware.elf
+ *     firmware.map: `avr-nm -n --defined-only firmware.elf` (function names, PC -> symbol)
+ */
+
+#include "building.h"
+#include "ic165.h"
+
+#include "avr_ioport.h"
+#include "avr_spi.h"
+#include "avr_uart.h"
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_irq.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =================================================================================
+// --- 상수 정의 ---
+// =================================================================================
+#define HARNESS_MCU "atmega328p"
+#define HARNESS_FREQUENCY 16000000UL
+#define HARNESS_DEFAULT_SECONDS 12
+#define VECTOR_COUNT 26 // ATmega328P: 1 ~ 25 (0 = RESET)
+#define MAX_SYMBOLS 1024
+#define MAX_FUNCS 16
+#define MAX_BUDGETS 64
+
+// 보드 배선 (pinmacro.h와 같게)
+#define PIN_HX711_DT 0 // PC0
+#define PIN_HX711_SCK 1 // PC1
+#define PIN_165_LOAD 2  // PC2 (CP_LATCH_165, LOW = 병렬 로드)
+#define PIN_HOME 3      // PC3
+#define PIN_DOOR 4      // PC4
+
+#define HX711_PERIOD_US 100000 // 10 SPS
+#define HX711_RAW 142600L      // 빈 카
+#define PEER_CAR_ID 1
+#define PEER_DELAY_US 5000 // 카 1의 TDMA 슬롯 (LINK_SLOT_MS)
+#define LINK_SYNC 0xA5
+#define LINK_MSG_STATE 0x01
+#define LINK_MAX_FRAME 32
+
+// 스위치 시나리오 (시각 ms, 스위치 비트, 누름 시간 ms)
+typedef struct
+{
+  uint32_t at_ms;
+  uint8_t bit;
+  uint16_t hold_ms;
+} press_t;
+
+typedef struct
+{
+  uint64_t count;
+  uint64_t total;
+  uint64_t max;
+} stat_t;
+
+typedef struct
+{
+  char name[48];
+  uint32_t addr; // 바이트 주소
+} symbol_t;
+
+typedef struct
+{
+  const char *name;
+  uint32_t addr;
+  uint8_t active;
+  uint8_t in_isr;     // ISR 안에서 호출됨 (ISR 사이클을 빼지 않음)
+  uint16_t sp;        // 진입 시 SP (반환 주소가 쌓인 뒤)
+  uint32_t ret_pc;
+  uint64_t start;
+  uint64_t isr_snap;
+  stat_t stat;
+} func_t;
+
+typedef struct
+{
+  char kind[16];
+  char name[32];
+  uint64_t limit;
+} budget_t;
+
+static const char *vector_names[VECTOR_COUNT] = {
+    "RESET", "INT0", "INT1", "PCINT0", "PCINT1", "PCINT2", "WDT",
+    "TIMER2_COMPA", "TIMER2_COMPB", "TIMER2_OVF", "TIMER1_CAPT", "TIMER1_COMPA", "TIMER1_COMPB", "TIMER1_OVF",
+    "TIMER0_COMPA", "TIMER0_COMPB", "TIMER0_OVF", "SPI_STC", "USART_RX", "USART_UDRE", "USART_TX",
+    "ADC", "EE_READY", "ANALOG_COMP", "TWI", "SPM_READY"};
+
+// 카 호출 -> 도착해 문 열림(서보) -> 닫힘 버튼 -> 홀 호출로 복귀
+static const press_t presses[] = {
+    {1500, SW_CAR_FLOOR_BIT(2), 100},
+    {7500, SW_CAR_CLOSE_BIT, 100},
+    {9000, SW_CALL_BASE_BIT, 100}, // 첫 번째 홀 버튼 (1층 상행)
+};
+
+// =================================================================================
+// --- 전역 변수 ---
+// =================================================================================
+static avr_t *avr;
+
+// 측정
+static stat_t isr_stat[VECTOR_COUNT];
+static stat_t isr_latency[VECTOR_COUNT];
+static uint64_t isr_raised[VECTOR_COUNT];
+static uint64_t isr_start;
+static uint8_t isr_running = 0; // 실행 중인 벡터 (0 = 없음, 중첩 인터럽트 없음)
+static uint64_t isr_cycles_total = 0;
+
+static stat_t irqoff_main, irqoff_any;
+static uint32_t irqoff_main_pc, irqoff_any_pc;
+static uint64_t irqoff_start;
+static uint32_t irqoff_pc;
+static uint8_t irqoff_in_isr;
+
+static stat_t loop_stat;
+static uint64_t wake_cycle;
+static uint64_t wake_isr_snap;
+
+static symbol_t symbols[MAX_SYMBOLS];
+static int symbol_count = 0;
+static func_t funcs[MAX_FUNCS];
+static int func_count = 0;
+static budget_t budgets[MAX_BUDGETS];
+static int budget_count = 0;
+
+// 주변 장치
+static avr_irq_t *spi_in;
+static avr_irq_t *uart_in;
+static avr_irq_t *dt_pin;
+static uint8_t switches[IC165_CHAIN_BYTES]; // 1 = 눌림
+static uint8_t stage165[IC165_CHAIN_BYTES];
+static uint8_t hx_ready = 0, hx_bits = 0, hx_sck = 0;
+static long hx_value = 0;
+static uint32_t noise = 1;
+
+static uint8_t rx_frame[LINK_MAX_FRAME];
+static uint8_t rx_len = 0;
+static uint8_t peer_frame[LINK_MAX_FRAME];
+static uint8_t peer_len = 0;
+static uint8_t peer_seq = 0;
+static uint32_t peer_frames = 0;
+
+// =================================================================================
+// --- 심볼 / 예산 ---
+// =================================================================================
+
+static void load_map(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  char line[128], type;
+  unsigned long addr;
+  char name[48];
+
+  if (!f)
+  {
+    perror(path);
+    exit(2);
+  }
+
+  while (fgets(line, sizeof(line), f) && symbol_count < MAX_SYMBOLS)
+  {
+    if (sscanf(line, "%lx %c %47s", &addr, &type, name) != 3) continue;
+    if (type != 'T' && type != 't') continue; // .text만
+    symbols[symbol_count].addr = (uint32_t)addr;
+    strcpy(symbols[symbol_count].name, name);
+    symbol_count++;
+  }
+  fclose(f);
+}
+
+static const symbol_t *symbol_at(uint32_t pc)
+{
+  const symbol_t *best = NULL;
+  for (int i = 0; i < symbol_count; i++)
+  {
+    if (symbols[i].addr <= pc && (!best || symbols[i].addr > best->addr)) best = &symbols[i];
+  }
+  return best;
+}
+
+static const char *pc_name(uint32_t pc)
+{
+  static char buf[2][80];
+  static int k = 0;
+  const symbol_t *s = symbol_at(pc);
+
+  k ^= 1;
+  if (s)
+    snprintf(buf[k], sizeof(buf[k]), "0x%04x <%s+0x%x>", pc, s->name, pc - s->addr);
+  else
+    snprintf(buf[k], sizeof(buf[k]), "0x%04x", pc);
+  return buf[k];
+}
+
+static void watch_function(const char *name)
+{
+  for (int i = 0; i < func_count; i++)
+  {
+    if (!strcmp(funcs[i].name, name)) return;
+  }
+  if (func_count >= MAX_FUNCS) return;
+
+  func_t *fn = &funcs[func_count++];
+  fn->name = strdup(name);
+  fn->addr = UINT32_MAX;
+  for (int i = 0; i < symbol_count; i++)
+  {
+    if (!strcmp(symbols[i].name, name)) fn->addr = symbols[i].addr;
+  }
+}
+
+// 형식: <종류> <이름> <최대 사이클>  (# 주석)
+//   isr <벡터> / latency <벡터|any> / irqoff <main|any> / loop max / func <함수>
+static void load_budgets(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  char line[160];
+
+  if (!f)
+  {
+    perror(path);
+    exit(2);
+  }
+
+  while (fgets(line, sizeof(line), f) && budget_count < MAX_BUDGETS)
+  {
+    budget_t *b = &budgets[budget_count];
+    unsigned long long limit;
+
+    char *hash = strchr(line, '#');
+    if (hash) *hash = 0;
+    if (sscanf(line, "%15s %31s %llu", b->kind, b->name, &limit) != 3) continue;
+    b->limit = limit;
+    budget_count++;
+
+    if (!strcmp(b->kind, "func")) watch_function(b->name);
+  }
+  fclose(f);
+}
+
+// =================================================================================
+// --- 측정 ---
+// =================================================================================
+
+static void stat_add(stat_t *s, uint64_t value)
+{
+  s->count++;
+  s->total += value;
+  if (value > s->max) s->max = value;
+}
+
+static double cycles_us(uint64_t cycles)
+{
+  return cycles * 1e6 / HARNESS_FREQUENCY;
+}
+
+static void on_vector_pending(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+  int v = (int)(intptr_t)param;
+  if (value && !isr_raised[v]) isr_raised[v] = avr->cycle;
+}
+
+static void on_vector_running(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+  int v = (int)(intptr_t)param;
+
+  if (value)
+  {
+    isr_running = (uint8_t)v;
+    isr_start = avr->cycle;
+    if (isr_raised[v]) stat_add(&isr_latency[v], avr->cycle - isr_raised[v]);
+    isr_raised[v] = 0;
+  }
+  else if (isr_running == v)
+  {
+    uint64_t cycles = avr->cycle - isr_start;
+    stat_add(&isr_stat[v], cycles);
+    isr_cycles_total += cycles;
+    isr_running = 0;
+  }
+}
+
+static uint16_t stack_pointer(void)
+{
+  return avr->data[R_SPL] | (avr->data[R_SPH] << 8);
+}
+
+// 명령 하나를 실행한 뒤 호출: SREG I, 슬립, 함수 진입/반환 확인
+static void observe(uint8_t *was_enabled, int *was_sleeping, uint32_t last_pc)
+{
+  uint8_t enabled = avr->sreg[S_I];
+
+  // 인터럽트 금지 구간 (ISR 본문 포함)
+  if (*was_enabled && !enabled)
+  {
+    irqoff_start = avr->cycle;
+    irqoff_pc = isr_running ? avr->pc : last_pc;
+    irqoff_in_isr = isr_running != 0;
+  }
+  else if (!*was_enabled && enabled && irqoff_start)
+  {
+    uint64_t len = avr->cycle - irqoff_start;
+    if (len > irqoff_any.max) irqoff_any_pc = irqoff_pc;
+    stat_add(&irqoff_any, len);
+    if (!irqoff_in_isr)
+    {
+      if (len > irqoff_main.max) irqoff_main_pc = irqoff_pc;
+      stat_add(&irqoff_main, len);
+    }
+  }
+  *was_enabled = enabled;
+
+  // 메인 루프 1회 = 깨어남부터 다음 슬립까지 (그 사이 ISR 사이클 제외)
+  int sleeping = avr->state == cpu_Sleeping;
+  if (*was_sleeping && !sleeping)
+  {
+    wake_cycle = avr->cycle;
+    wake_isr_snap = isr_cycles_total;
+  }
+  else if (!*was_sleeping && sleeping && wake_cycle)
+  {
+    stat_add(&loop_stat, (avr->cycle - wake_cycle) - (isr_cycles_total - wake_isr_snap));
+  }
+  *was_sleeping = sleeping;
+
+  // 함수: 첫 명령 도달 시 진입, 반환 주소로 SP가 되돌아오면 반환
+  for (int i = 0; i < func_count; i++)
+  {
+    func_t *fn = &funcs[i];
+
+    if (!fn->active && avr->pc == fn->addr)
+    {
+      uint16_t sp = stack_pointer();
+      fn->active = 1;
+      fn->sp = sp;
+      fn->ret_pc = ((avr->data[sp + 1] << 8) | avr->data[sp + 2]) * 2; // CALL은 상위 바이트가 낮은 주소
+      fn->start = avr->cycle;
+      fn->in_isr = isr_running != 0;
+      fn->isr_snap = isr_cycles_total;
+    }
+    else if (fn->active && avr->pc == fn->ret_pc && stack_pointer() == fn->sp + 2)
+    {
+      uint64_t cycles = avr->cycle - fn->start;
+      if (!fn->in_isr) cycles -= isr_cycles_total - fn->isr_snap;
+      stat_add(&fn->stat, cycles);
+      fn->active = 0;
+    }
+  }
+}
+
+// =================================================================================
+// --- 74HC165 체인 (SPI) ---
+// =================================================================================
+
+static void on_165_load(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+  if (!value)
+  {
+    for (int k = 0; k < IC165_CHAIN_BYTES; k++) stage165[k] = ~switches[k]; // Active Low
+  }
+}
+
+static void on_spi_byte(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+  // 마지막 단의 바이트부터 나오고, 체인이 한 바이트씩 시프트
+  uint8_t out = stage165[IC165_CHAIN_BYTES - 1];
+  for (int k = IC165_CHAIN_BYTES - 1; k > 0; k--) stage165[k] = stage165[k - 1];
+  stage165[0] = 0xFF;
+  avr_raise_irq(spi_in, out);
+}
+
+static void set_switch(uint8_t bit, uint8_t pressed)
+{
+  if (pressed)
+    switches[bit >> 3] |= 1 << (bit & 7);
+  else
+    switches[bit >> 3] &= ~(1 << (bit & 7));
+}
+
+static avr_cycle_count_t release_switch(struct avr_t *a, avr_cycle_count_t when, void *param)
+{
+  set_switch((uint8_t)(intptr_t)param, 0);
+  return 0;
+}
+
+static avr_cycle_count_t press_switch(struct avr_t *a, avr_cycle_count_t when, void *param)
+{
+  const press_t *p = param;
+  set_switch(p->bit, 1);
+  avr_cycle_timer_register_usec(a, p->hold_ms * 1000UL, release_switch, (void *)(intptr_t)p->bit);
+  return 0;
+}
+
+// =================================================================================
+// --- HX711 ---
+// =================================================================================
+
+static avr_cycle_count_t hx711_convert(struct avr_t *a, avr_cycle_count_t when, void *param)
+{
+  if (!hx_bits)
+  {
+    noise = noise * 1103515245UL + 12345UL;
+    hx_value = (HX711_RAW + (long)((noise >> 16) % 33) - 16) & 0xFFFFFFL;
+    hx_ready = 1;
+    avr_raise_irq(dt_pin, 0); // 변환 완료
+  }
+  return when + avr_usec_to_cycles(a, HX711_PERIOD_US);
+}
+
+static void on_hx711_sck(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+  // 상승 에지마다 다음 비트, 25번째 펄스 후 DT HIGH
+  if (value && !hx_sck && hx_ready)
+  {
+    if (hx_bits < 24)
+    {
+      avr_raise_irq(dt_pin, (hx_value >> (23 - hx_bits)) & 1);
+      hx_bits++;
+    }
+    else
+    {
+      avr_raise_irq(dt_pin, 1);
+      hx_bits = 0;
+      hx_ready = 0;
+    }
+  }
+  hx_sck = value != 0;
+}
+
+// =================================================================================
+// --- UART 상대 카 ---
+// 이 카의 상태 방송(STATE)을 받으면 카 1의 슬롯에서 같은 내용을 카 1로 보냄
+// =================================================================================
+
+static uint8_t crc8_update(uint8_t crc, uint8_t data)
+{
+  crc ^= data;
+  for (int i = 0; i < 8; i++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+  return crc;
+}
+
+static avr_cycle_count_t peer_send(struct avr_t *a, avr_cycle_count_t when, void *param)
+{
+  for (uint8_t i = 0; i < peer_len; i++) avr_raise_irq(uart_in, peer_frame[i]); // simavr가 보율에 맞춰 수신
+  peer_frames++;
+  peer_len = 0;
+  return 0;
+}
+
+static void on_uart_byte(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+  uint8_t byte = (uint8_t)value;
+
+  if (rx_len == 0 && byte != LINK_SYNC) return;
+  if (rx_len >= LINK_MAX_FRAME)
+  {
+    rx_len = 0;
+    return;
+  }
+  rx_frame[rx_len++] = byte;
+
+  // SYNC DST SRC TYPE SEQ LEN payload CRC
+  if (rx_len < 6 || rx_len < 7 + rx_frame[5]) return;
+
+  uint8_t len = rx_frame[5];
+  if (rx_frame[3] == LINK_MSG_STATE && !peer_len && len + 7 <= LINK_MAX_FRAME)
+  {
+    uint8_t crc = 0;
+    memcpy(peer_frame, rx_frame, len + 7);
+    peer_frame[2] = PEER_CAR_ID;
+    peer_frame[4] = peer_seq++;
+    if (len) peer_frame[6] = PEER_CAR_ID; // car_state_t.car_id
+    for (uint8_t i = 1; i < 6 + len; i++) crc = crc8_update(crc, peer_frame[i]);
+    peer_frame[6 + len] = crc;
+    peer_len = len + 7;
+    avr_cycle_timer_register_usec(avr, PEER_DELAY_US, peer_send, NULL);
+  }
+  rx_len = 0;
+}
+
+// =================================================================================
+// --- 보고 ---
+// =================================================================================
+
+static int check(const char *kind, const char *name, uint64_t value, uint8_t ran)
+{
+  for (int i = 0; i < budget_count; i++)
+  {
+    if (strcmp(budgets[i].kind, kind) || strcmp(budgets[i].name, name)) continue;
+
+    if (!ran)
+    {
+      printf("FAIL %s %s: never ran\n", kind, name);
+      return 1;
+    }
+    if (value > budgets[i].limit)
+    {
+      printf("FAIL %s %s: %llu cycles > budget %llu\n", kind, name, (unsigned long long)value,
+             (unsigned long long)budgets[i].limit);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int report(void)
+{
+  int failures = 0;
+  uint64_t worst_latency = 0;
+
+  printf("\n%-14s %8s %8s %8s %9s %12s\n", "vector", "count", "avg", "max", "max us", "latency max");
+  for (int v = 1; v < VECTOR_COUNT; v++)
+  {
+    stat_t *s = &isr_stat[v];
+    if (!s->count) continue;
+    printf("%-14s %8llu %8llu %8llu %9.1f %12llu\n", vector_names[v], (unsigned long long)s->count,
+           (unsigned long long)(s->total / s->count), (unsigned long long)s->max, cycles_us(s->max),
+           (unsigned long long)isr_latency[v].max);
+    if (isr_latency[v].max > worst_latency) worst_latency = isr_latency[v].max;
+  }
+  for (int v = 1; v < VECTOR_COUNT; v++)
+  {
+    failures += check("isr", vector_names[v], isr_stat[v].max, isr_stat[v].count != 0);
+    failures += check("latency", vector_names[v], isr_latency[v].max, isr_latency[v].count != 0);
+  }
+  failures += check("latency", "any", worst_latency, 1);
+
+  printf("\ninterrupts disabled: worst %llu cycles (%.1f us) from %s\n", (unsigned long long)irqoff_any.max,
+         cycles_us(irqoff_any.max), pc_name(irqoff_any_pc));
+  printf("  outside ISRs:      worst %llu cycles (%.1f us) from %s\n", (unsigned long long)irqoff_main.max,
+         cycles_us(irqoff_main.max), pc_name(irqoff_main_pc));
+  failures += check("irqoff", "any", irqoff_any.max, 1);
+  failures += check("irqoff", "main", irqoff_main.max, 1);
+
+  if (loop_stat.count)
+  {
+    printf("\nmain loop: %llu iterations, avg %llu, max %llu cycles (%.1f us)\n", (unsigned long long)loop_stat.count,
+           (unsigned long long)(loop_stat.total / loop_stat.count), (unsigned long long)loop_stat.max,
+           cycles_us(loop_stat.max));
+  }
+  failures += check("loop", "max", loop_stat.max, loop_stat.count != 0);
+
+  printf("\n%-20s %8s %8s %8s %9s\n", "function", "calls", "avg", "max", "max us");
+  for (int i = 0; i < func_count; i++)
+  {
+    func_t *fn = &funcs[i];
+    if (fn->addr == UINT32_MAX)
+      printf("%-20s not in map (inlined or removed?)\n", fn->name);
+    else if (fn->stat.count)
+      printf("%-20s %8llu %8llu %8llu %9.1f\n", fn->name, (unsigned long long)fn->stat.count,
+             (unsigned long long)(fn->stat.total / fn->stat.count), (unsigned long long)fn->stat.max,
+             cycles_us(fn->stat.max));
+    else
+      printf("%-20s never called\n", fn->name);
+    failures += check("func", fn->name, fn->stat.max, fn->stat.count != 0);
+  }
+
+  printf("\npeer frames sent: %lu\n", (unsigned long)peer_frames);
+  printf("%s (%d budget%s exceeded)\n", failures ? "FAILED" : "OK", failures, failures == 1 ? "" : "s");
+  return failures ? 1 : 0;
+}
+
+// =================================================================================
+// --- 메인 ---
+// =================================================================================
+
+static void usage(void)
+{
+  fprintf(stderr, "usage: harness [-t seconds] [-m firmware.map] [-b budgets.txt] firmware.elf\n");
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  const char *elf = NULL, *map = NULL, *budget_path = NULL;
+  double seconds = HARNESS_DEFAULT_SECONDS;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "-t") && i + 1 < argc)
+      seconds = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+      map = argv[++i];
+    else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+      budget_path = argv[++i];
+    else if (argv[i][0] != '-' && !elf)
+      elf = argv[i];
+    else
+      usage();
+  }
+  if (!elf) usage();
+
+  if (map) load_map(map);
+  if (budget_path) load_budgets(budget_path);
+  watch_function("ic595_update");
+  watch_function("ic595_exchange");
+  watch_function("servo_set_angle");
+
+  elf_firmware_t fw;
+  memset(&fw, 0, sizeof(fw));
+  if (elf_read_firmware(elf, &fw))
+  {
+    fprintf(stderr, "harness: cannot read %s\n", elf);
+    return 2;
+  }
+  if (!fw.mmcu[0]) strcpy(fw.mmcu, HARNESS_MCU);
+  if (!fw.frequency) fw.frequency = HARNESS_FREQUENCY;
+
+  avr = avr_make_mcu_by_name(fw.mmcu);
+  if (!avr)
+  {
+    fprintf(stderr, "harness: unknown mcu %s\n", fw.mmcu);
+    return 2;
+  }
+  avr_init(avr);
+  avr_load_firmware(avr, &fw);
+
+  // 인터럽트 벡터별 대기/실행 통지
+  for (int v = 1; v < VECTOR_COUNT; v++)
+  {
+    avr_irq_t *irq = avr_get_interrupt_irq(avr, v);
+    if (!irq) continue;
+    avr_irq_register_notify(irq + AVR_INT_IRQ_PENDING, on_vector_pending, (void *)(intptr_t)v);
+    avr_irq_register_notify(irq + AVR_INT_IRQ_RUNNING, on_vector_running, (void *)(intptr_t)v);
+  }
+
+  // 리미트 스위치 (외부 풀업, 눌리지 않음)
+  avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('C'), PIN_HOME), 1);
+  avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('C'), PIN_DOOR), 1);
+
+  // 74HC165 체인
+  spi_in = avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_INPUT);
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_OUTPUT), on_spi_byte, NULL);
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('C'), PIN_165_LOAD), on_165_load, NULL);
+  for (size_t i = 0; i < sizeof(presses) / sizeof(presses[0]); i++)
+  {
+    avr_cycle_timer_register_usec(avr, presses[i].at_ms * 1000UL, press_switch, (void *)&presses[i]);
+  }
+
+  // HX711
+  dt_pin = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('C'), PIN_HX711_DT);
+  avr_raise_irq(dt_pin, 1);
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('C'), PIN_HX711_SCK), on_hx711_sck, NULL);
+  avr_cycle_timer_register_usec(avr, HX711_PERIOD_US, hx711_convert, NULL);
+
+  // UART 상대 카 (simavr의 stdio 출력은 끔)
+  uint32_t flags = 0;
+  avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+  flags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+  uart_in = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT), on_uart_byte, NULL);
+
+  // 명령 단위 실행
+  avr_cycle_count_t end = (avr_cycle_count_t)(seconds * HARNESS_FREQUENCY);
+  uint8_t was_enabled = 0;
+  int was_sleeping = 0;
+
+  while (avr->cycle < end)
+  {
+    uint32_t pc = avr->pc;
+    int state = avr_run(avr);
+    if (state == cpu_Done || state == cpu_Crashed)
+    {
+      fprintf(stderr, "harness: cpu stopped (state %d) at %s\n", state, pc_name(avr->pc));
+      return 2;
+    }
+    observe(&was_enabled, &was_sleeping, pc);
+  }
+
+  printf("%s: %.1f s simulated (%llu cycles)\n", elf, seconds, (unsigned long long)avr->cycle);
+  return report();
+}
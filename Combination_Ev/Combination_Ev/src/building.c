@@ -0,0 +1,50 @@
+#include "building.h"
+
+// =================================================================================
+// --- 전역 변수 ---
+// =================================================================================
+static uint8_t hall_index[FLOOR_COUNT][2];     // [층-1][방향] -> 버튼 순번
+static uint8_t hall_button[HALL_CALL_COUNT];   // 버튼 순번 -> (층 << 1) | 방향
+
+// =================================================================================
+// --- 함수 구현 ---
+// =================================================================================
+
+void building_init(void)
+{
+  uint8_t index = 0;
+
+  // 층 순서, 같은 층은 상행 -> 하행 순으로 번호를 매김 (74595/74165 배치 순서와 같음)
+  for (uint8_t floor = 1; floor <= FLOOR_COUNT; floor++)
+  {
+    for (uint8_t dir = DIR_ASCENDING; dir <= DIR_DESCENDING; dir++)
+    {
+      uint32_t floors = (dir == DIR_ASCENDING) ? HALL_UP_FLOORS : HALL_DOWN_FLOORS;
+      if (floors & FLOOR_BIT(floor))
+      {
+        hall_index[floor - 1][dir] = index;
+        hall_button[index++] = (floor << 1) | dir;
+      }
+      else
+      {
+        hall_index[floor - 1][dir] = HALL_CALL_NONE;
+      }
+    }
+  }
+}
+
+uint8_t building_hall_index(uint8_t floor, uint8_t dir)
+{
+  if (floor < 1 || floor > FLOOR_COUNT || dir > DIR_DESCENDING) return HALL_CALL_NONE;
+  return hall_index[floor - 1][dir];
+}
+
+uint8_t building_hall_floor(uint8_t index)
+{
+  return hall_button[index] >> 1;
+}
+
+uint8_t building_hall_dir(uint8_t index)
+{
+  return hall_button[index] & 1;
+}
@@ -0,0 +1,97 @@
+#include "calls.h"
+
+// =================================================================================
+// --- 전역 변수 ---
+// =================================================================================
+static floor_mask_t car_calls = 0;  // 카 호출 (bit n = n+1층)
+static floor_mask_t up_calls = 0;   // 상행 홀 호출
+static floor_mask_t down_calls = 0; // 하행 홀 호출
+
+// =================================================================================
+// --- 함수 구현 ---
+// =================================================================================
+
+void calls_init(void)
+{
+  car_calls = 0;
+  up_calls = 0;
+  down_calls = 0;
+}
+
+void calls_add_car(uint8_t floor)
+{
+  if (floor < 1 || floor > FLOOR_COUNT) return;
+  car_calls |= FLOOR_BIT(floor);
+}
+
+void calls_add_hall(uint8_t floor, uint8_t dir)
+{
+  if (floor < 1 || floor > FLOOR_COUNT) return;
+
+  if (dir == DIR_ASCENDING)
+    up_calls |= FLOOR_BIT(floor);
+  else if (dir == DIR_DESCENDING)
+    down_calls |= FLOOR_BIT(floor);
+}
+
+void calls_clear(uint8_t floor, uint8_t kinds)
+{
+  if (floor < 1 || floor > FLOOR_COUNT) return;
+
+  floor_mask_t keep = ~FLOOR_BIT(floor);
+  if (kinds & CALLS_CAR) car_calls &= keep;
+  if (kinds & CALLS_UP) up_calls &= keep;
+  if (kinds & CALLS_DOWN) down_calls &= keep;
+}
+
+uint8_t calls_at(uint8_t floor)
+{
+  if (floor < 1 || floor > FLOOR_COUNT) return 0;
+
+  floor_mask_t bit = FLOOR_BIT(floor);
+  uint8_t kinds = 0;
+  if (car_calls & bit) kinds |= CALLS_CAR;
+  if (up_calls & bit) kinds |= CALLS_UP;
+  if (down_calls & bit) kinds |= CALLS_DOWN;
+  return kinds;
+}
+
+floor_mask_t calls_all(void)
+{
+  return car_calls | up_calls | down_calls;
+}
+
+floor_mask_t calls_above(uint8_t floor)
+{
+  // floor층의 비트(floor-1)보다 위의 비트만 남김
+  return calls_all() & FLOORS_ABOVE(floor);
+}
+
+floor_mask_t calls_below(uint8_t floor)
+{
+  // floor층의 비트(floor-1)보다 아래 비트만 남김
+  return calls_all() & FLOORS_BELOW(floor);
+}
+
+void calls_get(floor_mask_t *car, floor_mask_t *up, floor_mask_t *down)
+{
+  *car = car_calls;
+  *up = up_calls;
+  *down = down_calls;
+}
+
+uint8_t calls_count(void)
+{
+  uint8_t count = 0;
+  floor_mask_t maps[3] = {car_calls, up_calls, down_calls};
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    // 가장 낮은 1비트를 하나씩 지우며 세기 (Kernighan)
+    for (floor_mask_t m = maps[i]; m; m &= m - 1)
+    {
+      count++;
+    }
+  }
+  return count;
+}
@@ -0,0 +1,96 @@
+#include "eta.h"
+
+// =================================================================================
+// --- 전역 변수 ---
+// =================================================================================
+static uint16_t floor_ms = ETA_FLOOR_MS_INIT; // 학습된 층간 주행 시간
+
+// =================================================================================
+// --- 함수 구현 ---
+// =================================================================================
+
+uint16_t eta_estimate(const car_state_t *car, uint8_t floor, uint8_t dir)
+{
+  if (car->flags & (CAR_FLAG_OVERLOAD | CAR_FLAG_EMERGENCY)) return ETA_UNAVAILABLE;
+
+  uint32_t eta = 0;
+  floor_mask_t all = car->car_calls | car->up_calls | car->down_calls;
+  uint8_t f = car->floor;
+  uint8_t d = (car->state == ST_MOVING) ? car->motion_dir : car->travel_dir;
+
+  // 현재 문 상태에서 출발할 수 있을 때까지
+  switch (car->state)
+  {
+  case ST_DOOR_OPENING:
+    eta += ETA_STOP_MS;
+    break;
+  case ST_DOOR_OPENED:
+    eta += car->door_ms + ETA_DOOR_MOVE_MS; // 남은 유지 시간은 카가 보낸 값 (DOOR_HOLD_MS 기준)
+    break;
+  case ST_DOOR_CLOSING:
+    eta += ETA_DOOR_MOVE_MS;
+    break;
+  }
+
+  // 정지 중이면 호출 쪽으로 출발한다고 가정
+  if (d == DIR_IDLE)
+  {
+    if (floor > f)
+      d = DIR_ASCENDING;
+    else if (floor < f)
+      d = DIR_DESCENDING;
+    else
+      d = dir;
+  }
+
+  // LOOK 운행을 한 층씩 따라가며 시간 누적 (최악: 끝까지 갔다가 반대쪽 끝을 거쳐 돌아옴)
+  uint8_t moved = 0;
+  for (uint8_t i = 0; i < 3 * FLOOR_COUNT; i++)
+  {
+    floor_mask_t beyond = all & ((d == DIR_ASCENDING) ? FLOORS_ABOVE(f) : FLOORS_BELOW(f));
+    uint8_t target_ahead = (d == DIR_ASCENDING) ? (floor > f) : (floor < f);
+
+    if (f == floor && (d == dir || !beyond))
+    {
+      break; // 같은 방향으로 지나가거나 여기서 반전하므로 태울 수 있음
+    }
+
+    if (moved)
+    {
+      // 도착한 층의 기존 정지 (카 호출, 같은 방향 홀 호출, 반전 지점)
+      floor_mask_t bit = FLOOR_BIT(f);
+      floor_mask_t same = (d == DIR_ASCENDING) ? car->up_calls : car->down_calls;
+      if (((car->car_calls | same) & bit) || ((all & bit) && !beyond))
+      {
+        eta += ETA_STOP_MS;
+      }
+      moved = 0;
+    }
+
+    // 앞쪽에 호출도 목표도 없으면 그 자리에서 반전
+    if (!beyond && !target_ahead)
+    {
+      d = (d == DIR_ASCENDING) ? DIR_DESCENDING : DIR_ASCENDING;
+      continue;
+    }
+
+    f = (d == DIR_ASCENDING) ? f + 1 : f - 1;
+    eta += car->floor_ms;
+    moved = 1;
+  }
+
+  return (eta >= ETA_UNAVAILABLE) ? ETA_UNAVAILABLE - 1 : (uint16_t)eta;
+}
+
+void eta_learn_trip(uint8_t floors, uint16_t ms)
+{
+  if (floors == 0) return;
+
+  int16_t error = (int16_t)(ms / floors - floor_ms);
+  floor_ms += error >> ETA_LEARN_SHIFT;
+}
+
+uint16_t eta_floor_ms(void)
+{
+  return floor_ms;
+}
@@ -0,0 +1,55 @@
+/*
+ * event.c - ISR -> main loop single-producer/single-consumer event queue
+ * Head is written only by the producer (ISR), tail only by the consumer
+ * (main loop). Both indices are single bytes, so no locking is needed.
+ */
+
+#include "event.h"
+
+// =================================================================================
+// --- 전역 변수 ---
+// =================================================================================
+static volatile event_t event_buf[EVENT_QUEUE_SIZE]; // volatile: 인덱스 갱신과 순서가 바뀌지 않도록
+static volatile uint8_t event_head = 0; // 다음에 쓸 위치 (ISR만 변경)
+static volatile uint8_t event_tail = 0; // 다음에 읽을 위치 (메인 루프만 변경)
+static volatile uint8_t event_drop_count = 0;
+
+// =================================================================================
+// --- 함수 구현 ---
+// =================================================================================
+
+uint8_t event_push(uint8_t type, uint16_t data)
+{
+  uint8_t head = event_head;
+  uint8_t next = (head + 1) & (EVENT_QUEUE_SIZE - 1);
+
+  if (next == event_tail)
+  {
+    event_drop_count++;
+    return 0;
+  }
+
+  event_buf[head].type = type;
+  event_buf[head].data = data;
+  event_head = next; // 레코드를 다 쓴 뒤에 공개
+
+  return 1;
+}
+
+uint8_t event_pop(event_t *ev)
+{
+  uint8_t tail = event_tail;
+
+  if (tail == event_head) return 0;
+
+  ev->type = event_buf[tail].type;
+  ev->data = event_buf[tail].data;
+  event_tail = (tail + 1) & (EVENT_QUEUE_SIZE - 1); // 다 읽은 뒤에 슬롯 반환
+
+  return 1;
+}
+
+uint8_t event_dropped(void)
+{
+  return event_drop_count;
+}
@@ -0,0 +1,100 @@
+#include "group.h"
+#include "sched.h"
+
+// =================================================================================
+// --- 전역 변수 ---
+// =================================================================================
+static car_state_t peers[LINK_MAX_CARS];
+static uint16_t peer_seen_ms[LINK_MAX_CARS]; // 마지막 상태 수신 시각
+static uint8_t peer_alive = 0;               // 비트 = 카 번호
+
+// =================================================================================
+// --- 함수 구현 ---
+// =================================================================================
+
+void group_update(const car_state_t *state)
+{
+  uint8_t id = state->car_id;
+  if (id >= LINK_MAX_CARS || id == CAR_ID) return;
+
+  peers[id] = *state;
+  peer_seen_ms[id] = sched_millis();
+  peer_alive |= (1 << id);
+}
+
+uint8_t group_expire(void)
+{
+  uint16_t now = sched_millis();
+  uint8_t expired = 0;
+
+  for (uint8_t id = 0; id < LINK_MAX_CARS; id++)
+  {
+    if ((peer_alive & (1 << id)) && (uint16_t)(now - peer_seen_ms[id]) >= LINK_PEER_TIMEOUT_MS)
+    {
+      expired |= (1 << id);
+    }
+  }
+
+  peer_alive &= ~expired;
+  return expired;
+}
+
+uint8_t group_alive(void)
+{
+  return peer_alive;
+}
+
+uint8_t group_count(void)
+{
+  uint8_t count = 0;
+  for (uint8_t m = peer_alive; m; m &= m - 1)
+  {
+    count++;
+  }
+  return count;
+}
+
+const car_state_t *group_peer(uint8_t id)
+{
+  return &peers[id];
+}
+
+void group_hall_calls(floor_mask_t *up, floor_mask_t *down)
+{
+  *up = 0;
+  *down = 0;
+
+  for (uint8_t id = 0; id < LINK_MAX_CARS; id++)
+  {
+    if (peer_alive & (1 << id))
+    {
+      *up |= peers[id].up_calls;
+      *down |= peers[id].down_calls;
+    }
+  }
+}
+
+uint8_t group_best_car(const car_state_t *me, uint8_t floor, uint8_t dir)
+{
+  uint8_t best = CAR_ID;
+  uint16_t best_eta = eta_estimate(me, floor, dir);
+
+  // 번호 순으로 비교하므로 ETA가 같으면 번호가 작은 카가 남음
+  for (uint8_t id = 0; id < LINK_MAX_CARS; id++)
+  {
+    if (!(peer_alive & (1 << id))) continue; // 자기 자신은 peer_alive에 없음
+
+    uint16_t eta = eta_estimate(&peers[id], floor, dir);
+    if (eta < best_eta || (eta == best_eta && id < best))
+    {
+      best = id;
+      best_eta = eta;
+    }
+  }
+  return best;
+}
+
+uint8_t group_is_leader(void)
+{
+  return (peer_alive & ((1 << CAR_ID) - 1)) == 0;
+}
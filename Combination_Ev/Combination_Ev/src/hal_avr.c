@@ -0,0 +1,364 @@
+/*
+ * hal_avr.c - ATmega328P backend of the hardware abstraction layer
+ * All register access and interrupt vectors live here; each vector only
+ * forwards to the driver's handler declared in hal.h.
+ */
+
+#include "hal.h"
+
+#include <avr/sleep.h>
+#include <util/delay.h>
+
+// =================================================================================
+// --- 시스템 ---
+// =================================================================================
+
+void hal_irq_enable(void)
+{
+  sei();
+}
+
+void hal_idle(void)
+{
+  // 틱 인터럽트가 깨울 때까지 대기 (Timer0, UART, 핀 변화 인터럽트 모두 Idle에서 동작)
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_mode();
+}
+
+void hal_delay_us(uint16_t us)
+{
+  while (us--) _delay_us(1);
+}
+
+void hal_delay_ms(uint16_t ms)
+{
+  while (ms--) _delay_ms(1);
+}
+
+// =================================================================================
+// --- Timer0: 1ms 시스템 틱 ---
+// =================================================================================
+
+void hal_tick_init(void)
+{
+  // CTC 모드, 16MHz / 64 / 250 = 1kHz
+  TCCR0A = (1 << WGM01);
+  OCR0A = 249;
+  TIMSK0 |= (1 << OCIE0A);
+  TCCR0B = (1 << CS01) | (1 << CS00);
+}
+
+ISR(TIMER0_COMPA_vect)
+{
+  sched_tick();
+}
+
+// =================================================================================
+// --- SPI: 74HC595 / 74HC165 체인 ---
+// SER(PB3) = MOSI, 165 출력(PB4) = MISO, SRCLK(PB5) = SCK
+// RCLK(PB2)는 SS 핀이므로 마스터 모드 유지를 위해 반드시 출력이어야 합니다.
+// =================================================================================
+
+void hal_spi_init(void)
+{
+  // MOSI, SCK, SS(RCLK) 출력 / MISO 입력
+  SER_595_DDR |= (1 << SER_595_PIN);
+  SRCLK_DDR |= (1 << SRCLK_PIN);
+  RCLK_595_DDR |= (1 << RCLK_595_PIN);
+  MISO_165_DDR &= ~(1 << MISO_165_PIN);
+
+  // 165 Load 비활성(HIGH)
+  CP_LATCH_165_DDR |= (1 << CP_LATCH_165_PIN);
+  CP_LATCH_165_PORT |= (1 << CP_LATCH_165_PIN);
+
+  // SPI 마스터, MSB First, Mode 0 (상승 에지에서 샘플/시프트)
+  SPCR = (1 << SPE) | (1 << MSTR);
+
+  // fosc/2 = 8MHz (1바이트당 1us)
+  SPSR = (1 << SPI2X);
+}
+
+uint8_t hal_spi_transfer(uint8_t data)
+{
+  SPDR = data;
+  while (!(SPSR & (1 << SPIF))); // 8비트 전송 완료까지 대기 (16 클럭)
+  return SPDR;
+}
+
+void hal_165_load(void)
+{
+  CP_LATCH_165_PORT &= ~(1 << CP_LATCH_165_PIN); // Load LOW
+  CP_LATCH_165_PORT |= (1 << CP_LATCH_165_PIN);  // Load HIGH (데이터 캡처)
+}
+
+void hal_595_latch(uint8_t level)
+{
+  if (level)
+    RCLK_595_PORT |= (1 << RCLK_595_PIN);
+  else
+    RCLK_595_PORT &= ~(1 << RCLK_595_PIN);
+}
+
+// =================================================================================
+// --- 입력 핀: PCINT1 (PC0: HX711 DT, PC3: Home Sw., PC4: Door Closed Sw.) ---
+// =================================================================================
+
+void hal_inputs_init(void)
+{
+  // 외부 풀업 저항이 있으므로, 내부 풀업(PORTC) 설정은 하지 않음
+  LS_HOME_DDR &= ~(1 << LS_HOME_PIN);
+  LS_DOOR_CLOSED_DDR &= ~(1 << LS_DOOR_CLOSED_PIN);
+
+  // 버튼은 74HC165로 샘플링 (PD5 핀 변화 인터럽트 미사용)
+  // PD5를 입력으로 설정 (외부 풀업 저항 사용)
+  DDRD &= ~(1 << PD5);
+  PORTD &= ~(1 << PD5);
+
+  // PCINT1: PC3(Home), PC4(Door Closed) 인터럽트 활성화
+  PCICR |= (1 << PCIE1);
+  PCMSK1 |= (1 << PCINT11) | (1 << PCINT12); // PC3 = PCINT11, PC4 = PCINT12
+}
+
+uint8_t hal_inputs(void)
+{
+  uint8_t pinc = PINC; // DT(PC0), Home(PC3), Door(PC4) 모두 PORTC
+  uint8_t pins = 0;
+
+  if (pinc & (1 << HX711_DT_PIN)) pins |= HAL_IN_HX711_DT;
+  if (pinc & (1 << LS_HOME_PIN)) pins |= HAL_IN_HOME;
+  if (pinc & (1 << LS_DOOR_CLOSED_PIN)) pins |= HAL_IN_DOOR_CLOSED;
+  return pins;
+}
+
+ISR(PCINT1_vect)
+{
+  isr_on_pin_change(hal_inputs());
+}
+
+// =================================================================================
+// --- HX711 ---
+// =================================================================================
+
+void hal_hx711_init(void)
+{
+  // SCK 핀은 MCU가 제어하므로 출력, DT 핀은 HX711의 신호를 읽어야 하므로 입력으로 설정
+  HX711_SCK_DDR |= (1 << HX711_SCK_PIN);
+  HX711_DT_DDR &= ~(1 << HX711_DT_PIN);
+}
+
+void hal_hx711_sck(uint8_t level)
+{
+  if (level)
+    HX711_SCK_PORT |= (1 << HX711_SCK_PIN);
+  else
+    HX711_SCK_PORT &= ~(1 << HX711_SCK_PIN);
+}
+
+void hal_hx711_irq(uint8_t enable)
+{
+  // PC0 = PCINT8 (PCINT1 그룹)
+  if (enable)
+  {
+    PCMSK1 |= (1 << PCINT8);
+    PCICR |= (1 << PCIE1);
+  }
+  else
+  {
+    PCMSK1 &= ~(1 << PCINT8);
+  }
+}
+
+// =================================================================================
+// --- 스텝모터: ULN2003 + Timer2 (CTC, 1024분주, 틱당 64us) ---
+// =================================================================================
+
+void hal_stepper_init(void)
+{
+  // 스텝모터 제어핀들을 출력으로 설정
+  STEPPER_1_DDR |= (1 << STEPPER_1_PIN);
+  STEPPER_2_DDR |= (1 << STEPPER_2_PIN);
+  STEPPER_3_DDR |= (1 << STEPPER_3_PIN);
+  STEPPER_4_DDR |= (1 << STEPPER_4_PIN);
+
+  // 모든 핀을 LOW로 초기화
+  hal_stepper_coils(0x00);
+
+  // Timer2: CTC 모드 (TOP = OCR2A), 인터럽트는 이동 시작 시에만 활성화
+  TCCR2A = (1 << WGM21);
+  TCCR2B = 0; // 정지 상태로 시작
+  TIMSK2 &= ~(1 << OCIE2A);
+}
+
+void hal_stepper_coils(uint8_t pattern)
+{
+  // 각 비트를 해당 핀에 출력
+  if (pattern & 0x01)
+    STEPPER_1_PORT |= (1 << STEPPER_1_PIN);
+  else
+    STEPPER_1_PORT &= ~(1 << STEPPER_1_PIN);
+
+  if (pattern & 0x02)
+    STEPPER_2_PORT |= (1 << STEPPER_2_PIN);
+  else
+    STEPPER_2_PORT &= ~(1 << STEPPER_2_PIN);
+
+  if (pattern & 0x04)
+    STEPPER_3_PORT |= (1 << STEPPER_3_PIN);
+  else
+    STEPPER_3_PORT &= ~(1 << STEPPER_3_PIN);
+
+  if (pattern & 0x08)
+    STEPPER_4_PORT |= (1 << STEPPER_4_PIN);
+  else
+    STEPPER_4_PORT &= ~(1 << STEPPER_4_PIN);
+}
+
+void hal_step_timer_start(uint8_t ticks)
+{
+  OCR2A = ticks - 1;
+  TCNT2 = 0;
+  TIFR2 = (1 << OCF2A);
+  TIMSK2 |= (1 << OCIE2A);
+  TCCR2B = (1 << CS22) | (1 << CS21) | (1 << CS20); // 1024분주로 타이머 시작
+}
+
+void hal_step_timer_period(uint8_t ticks)
+{
+  OCR2A = ticks - 1;
+}
+
+void hal_step_timer_stop(void)
+{
+  TIMSK2 &= ~(1 << OCIE2A);
+  TCCR2B = 0;
+}
+
+ISR(TIMER2_COMPA_vect)
+{
+  stepper_on_timer();
+}
+
+// =================================================================================
+// --- 서보: Timer1 Fast PWM (Mode 14, TOP = ICR1), 50Hz ---
+// =================================================================================
+
+void hal_servo_init(void)
+{
+  // 1. PB1(OC1A) 핀을 출력으로 설정
+  SERVO_DDR |= (1 << SERVO_PIN);
+
+  // 2. Fast PWM 모드 (TOP=ICR1, Mode 14) 설정
+  TCCR1A |= (1 << WGM11);
+  TCCR1B |= (1 << WGM13) | (1 << WGM12);
+
+  // 3. 비반전 모드 설정 (펄스가 OCR1A 값에 따라 길어짐)
+  TCCR1A |= (1 << COM1A1);
+
+  // 4. 주기(Period) 설정 (50Hz -> 20ms)
+  // 16MHz / 8(prescaler) / 40000(ticks) = 50Hz
+  ICR1 = 39999;
+
+  // 5. 8분주 프리스케일러로 타이머 시작
+  TCCR1B |= (1 << CS11);
+}
+
+void hal_servo_pulse(uint16_t us)
+{
+  // 타이머 클럭 = 16MHz / 8 = 2MHz -> 1틱당 0.5us
+  // OCR 값 = 펄스폭(us) / 0.5(us/틱) = 펄스폭 * 2 (OCR1A는 이중 버퍼링)
+  OCR1A = us * 2;
+}
+
+void hal_servo_period_irq(uint8_t enable)
+{
+  if (enable)
+  {
+    TIFR1 = (1 << TOV1);    // 이전 주기의 플래그 제거
+    TIMSK1 |= (1 << TOIE1); // 다음 PWM 주기부터
+  }
+  else
+  {
+    TIMSK1 &= ~(1 << TOIE1);
+  }
+}
+
+ISR(TIMER1_OVF_vect)
+{
+  servo_on_period();
+}
+
+// =================================================================================
+// --- USART0 + RS-485 DE(PD2) ---
+// =================================================================================
+
+void hal_uart_init(uint32_t baudrate)
+{
+  // 2x mode (U2X0): UBRR = F_CPU / (8 * baud) - 1, 반올림
+  UCSR0A |= (1 << U2X0);
+  uint16_t ubrr = (F_CPU + 4 * baudrate) / (8 * baudrate) - 1;
+  UBRR0H = ubrr >> 8;
+  UBRR0L = ubrr & 0xFF;
+
+  // 8bit
+  UCSR0C |= 0x06;
+
+  // RS-485 DE: 평소에는 수신 (버스 해제)
+  RS485_DE_DDR |= (1 << RS485_DE_PIN);
+  RS485_DE_PORT &= ~(1 << RS485_DE_PIN);
+
+  // transmit enable (송신 인터럽트는 보낼 데이터가 있을 때만 켬)
+  UCSR0B |= (1 << TXEN0);
+
+  // receive(interrupt) enable
+  UCSR0B |= (1 << RXEN0) | (1 << RXCIE0);
+}
+
+void hal_uart_write(uint8_t data)
+{
+  // 이전 바이트의 TXC를 UDR0에 쓰기 전에 지움 (데이터시트 권장 순서)
+  // 이후 설정된 TXC는 이 바이트 이후의 완료이므로 DONE 인터럽트로 전환할 때 지우면 안 됨
+  UCSR0A = (UCSR0A & ((1 << U2X0) | (1 << MPCM0))) | (1 << TXC0);
+  UDR0 = data;
+}
+
+void hal_uart_tx_irq(uint8_t mode)
+{
+  switch (mode)
+  {
+  case HAL_UART_TX_IRQ_READY:
+    UCSR0B = (UCSR0B & ~(1 << TXCIE0)) | (1 << UDRIE0);
+    break;
+  case HAL_UART_TX_IRQ_DONE:
+    // 마지막 바이트 완료를 기다림 (이미 끝났으면 TXC가 남아 있어 바로 인터럽트 발생)
+    UCSR0B = (UCSR0B & ~(1 << UDRIE0)) | (1 << TXCIE0);
+    break;
+  default:
+    UCSR0B &= ~((1 << UDRIE0) | (1 << TXCIE0));
+    break;
+  }
+}
+
+void hal_rs485_de(uint8_t enable)
+{
+  if (enable)
+    RS485_DE_PORT |= (1 << RS485_DE_PIN);
+  else
+    RS485_DE_PORT &= ~(1 << RS485_DE_PIN);
+}
+
+ISR(USART_UDRE_vect)
+{
+  uart_on_tx_ready();
+}
+
+ISR(USART_TX_vect)
+{
+  uart_on_tx_done();
+}
+
+ISR(USART_RX_vect)
+{
+  uint8_t status = UCSR0A;
+  uint8_t data = UDR0;
+  uart_on_rx(data, (status & (1 << DOR0)) != 0);
+}
@@ -1,56 +1,85 @@
 #include "hx711.h"
-#include <avr/io.h>         // ATmega328P의 레지스터(DDRC, PINC 등) 사용
-#include <util/delay.h>     // _delay_ms(), _delay_us() 함수 사용
-#include <avr/interrupt.h>  // cli(), sei() 전역 인터럽트 제어 함수 사용
-
-// --- 하드웨어 핀 정의 ---
-#define HX711_DT_DDR      DDRC       // 데이터(DT) 핀의 데이터 방향 레지스터
-#define HX711_DT_PIN_REG  PINC       // 데이터(DT) 핀의 입력 값 레지스터
-#define HX711_DT_PIN      PC0        // 데이터(DT) 핀은 PORTC의 0번 핀
-#define HX711_SCK_DDR     DDRC       // 클럭(SCK) 핀의 데이터 방향 레지스터
-#define HX711_SCK_PORT    PORTC      // 클럭(SCK) 핀의 출력 값 레지스터
-#define HX711_SCK_PIN     PC1        // 클럭(SCK) 핀은 PORTC의 1번 핀
 
 // --- 내부 변수 (static 키워드로 이 파일 안에서만 사용하도록 제한) ---
 static long g_offset = 142600;      // 0점(Tare)의 기준이 되는 raw 값 (loadcell_tare 함수로 갱신됨)
-static float g_scale = 10.7143;     // raw 값을 무게(kg)로 변환하는 비율 상수 (캘리브레이션 필요!)
+static long g_enter_raw = 0x7FFFFFFFL; // 과적 진입 raw 임계값 (영점 조정 때 계산)
+static long g_exit_raw = 0x7FFFFFFFL;  // 과적 해제 raw 임계값 (영점 조정 때 계산)
+
+// 백그라운드 측정/필터 상태 (메인 루프의 loadcell_poll()에서 갱신)
+static long g_window[LOADCELL_MEDIAN_SIZE]; // 최근 raw 값 (입력 순서)
+static long g_sorted[LOADCELL_MEDIAN_SIZE]; // 같은 값들을 정렬한 배열 (중앙값 = 가운데 원소)
+static uint8_t g_window_head = 0;
+static long g_iir_acc = 0;                   // IIR 누산기 (raw << LOADCELL_IIR_SHIFT)
+static long g_filtered_raw = 0;              // 필터 출력 (raw 단위)
+static long g_latest_raw = 0;                // 가장 최근 raw 값
+static bool g_overload = false;              // 히스테리시스가 적용된 과적 상태
+static volatile bool g_sampling = false;     // 영점 조정 중에는 백그라운드 측정 중지
+static volatile bool g_data_ready = false;   // 변환 완료 (핀 변화 인터럽트가 설정, loadcell_poll()이 읽음)
 
 // --- 내부 함수 프로토타입 (이 파일 안에서만 사용할 함수이므로 static으로 선언) ---
 static long loadcell_read_raw(void);
+static long hx711_shift_in(void);
 static bool hx711_is_ready(void);
+static void loadcell_filter_reset(long raw);
+static long loadcell_median_update(long raw);
 
 // --- 외부 공개 함수 구현부 ---
 
 void loadcell_init(void) {
 	// SCK 핀은 MCU가 제어하므로 출력, DT 핀은 HX711의 신호를 읽어야 하므로 입력으로 설정
-	HX711_SCK_DDR |= (1 << HX711_SCK_PIN);
-	HX711_DT_DDR &= ~(1 << HX711_DT_PIN);
+	hal_hx711_init();
 	
 	// 전원 인가 직후 HX711이 불안정할 수 있으므로, SCK 핀을 제어해 강제로 리셋
-	HX711_SCK_PORT |= (1 << HX711_SCK_PIN);  // SCK를 HIGH로 만들어 Power Down 모드 진입
-	_delay_us(100);                         // 데이터시트 권장(60us)보다 길게 유지
-	HX711_SCK_PORT &= ~(1 << HX711_SCK_PIN);// SCK를 LOW로 내려 다시 깨움(리셋 완료)
+	hal_hx711_sck(1);    // SCK를 HIGH로 만들어 Power Down 모드 진입
+	hal_delay_us(100);   // 데이터시트 권장(60us)보다 길게 유지
+	hal_hx711_sck(0);    // SCK를 LOW로 내려 다시 깨움(리셋 완료)
 }
 
 void loadcell_tare(void) {
 	long sum = 0;
+
+	// 영점 측정 중에는 백그라운드 측정을 멈추고 직접 읽음
+	HAL_ATOMIC_BLOCK {
+		g_sampling = false;
+		g_data_ready = false;
+		hal_hx711_irq(0);
+	}
+
 	// TARE_SAMPLE_COUNT(10)번 만큼 측정하여 합산
 	for (uint8_t i = 0; i < TARE_SAMPLE_COUNT; i++) {
 		sum += loadcell_read_raw();
-		_delay_ms(10);
+		hal_delay_ms(10);
 	}
 	// 평균값을 계산하여 g_offset(0점 기준)으로 저장
 	g_offset = sum / TARE_SAMPLE_COUNT;
+
+	// 과적 진입/해제 무게를 raw 카운트로 미리 변환
+	long enter_raw = (long)(((int64_t)ELEVATOR_CAPACITY_G * LOADCELL_SCALE_Q16) >> 16);
+	long exit_raw = (long)(((int64_t)(ELEVATOR_CAPACITY_G - LOADCELL_HYSTERESIS_G) * LOADCELL_SCALE_Q16) >> 16);
+
+	// 필터를 영점 값으로 채워 첫 측정 전에는 0g으로 보이게 함
+	loadcell_filter_reset(g_offset);
+	g_enter_raw = g_offset + enter_raw;
+	g_exit_raw = g_offset + exit_raw;
+
+	// DT 하강(변환 완료) 시 핀 변화 인터럽트가 발생하도록 설정
+	HAL_ATOMIC_BLOCK {
+		g_sampling = true;
+		hal_hx711_irq(1);
+	}
 }
 
-float loadcell_get_weight_g(void) {
-	// (현재 raw 값 - 0점 raw 값) / 비율 상수 = 실제 무게(kg)
-	return (long)((float)(loadcell_read_raw() - g_offset) / g_scale);
+int32_t loadcell_get_weight_g(void) {
+	// (필터링된 raw 값 - 0점 raw 값) * (1 / 비율 상수) = 실제 무게(g)
+	long delta = g_filtered_raw - g_offset;
+	if (delta > LOADCELL_DELTA_LIMIT) delta = LOADCELL_DELTA_LIMIT;
+	if (delta < -LOADCELL_DELTA_LIMIT) delta = -LOADCELL_DELTA_LIMIT;
+	return (delta * LOADCELL_RECIP_Q16) >> 16;
 }
 
 bool loadcell_is_overload(void) {
-	// 현재 무게가 최대 허용 무게를 초과하는지 여부를 반환
-	return (loadcell_get_weight_g() > ELEVATOR_CAPACITY_G);
+	// 측정 시점에 판정해 둔 값을 반환
+	return g_overload;
 }
 
 
@@ -58,44 +87,130 @@ bool loadcell_is_overload(void) {
 
 // HX711이 데이터를 보낼 준비가 되었는지 확인 (DT 핀이 LOW이면 준비 완료)
 static bool hx711_is_ready(void) {
-	return !(HX711_DT_PIN_REG & (1 << HX711_DT_PIN));
+	return !(hal_inputs() & HAL_IN_HX711_DT);
 }
 
-// HX711으로부터 24비트 순수 데이터(raw value)를 읽어오는 저수준 함수
+// HX711으로부터 24비트 순수 데이터(raw value)를 읽어오는 저수준 함수 (대기함, 영점 조정 전용)
 static long loadcell_read_raw(void) {
+	while (!hx711_is_ready()) hal_idle(); // 데이터가 준비될 때까지 기다림 (틱마다 확인)
+	return hx711_shift_in();
+}
+
+// SCK HIGH 펄스 하나 (약 1us)
+// SCK가 60us 이상 HIGH면 HX711이 Power Down 되므로 HIGH 구간만 인터럽트를 막음
+// LOW 구간은 길어져도 데이터가 유지되므로 펄스 사이에는 인터럽트를 받음
+static void hx711_pulse(void) {
+	HAL_ATOMIC_BLOCK {
+		hal_hx711_sck(1);
+		hal_delay_us(1);
+		hal_hx711_sck(0);
+	}
+	hal_delay_us(1);
+}
+
+// DT가 LOW인 상태에서 25개의 클럭으로 24비트 값을 읽음 (메인 루프에서 호출)
+static long hx711_shift_in(void) {
 	long count = 0;
-	while (!hx711_is_ready()); // 데이터가 준비될 때까지 기다림
-	
-	cli(); // 정확한 통신을 위해 다른 인터럽트가 방해하지 못하도록 잠시 중단
-	
-	// 24번의 클럭 펄스를 발생시켜 1비트씩 데이터를 읽어옴
+
+	// 24번의 클럭 펄스를 발생시켜 1비트씩 데이터를 읽어옴 (상승 에지에서 나온 비트를 하강 뒤에 읽음)
 	for (uint8_t i = 0; i < 24; i++) {
-		HX711_SCK_PORT |= (1 << HX711_SCK_PIN);  // 클럭 펄스 시작 (HIGH)
-		_delay_us(1);
-		count = count << 1;                     // 기존 데이터를 왼쪽으로 1칸 밀어 자리를 만듦
-		HX711_SCK_PORT &= ~(1 << HX711_SCK_PIN); // 클럭 펄스 끝 (LOW)
-		_delay_us(1);
-		if (HX711_DT_PIN_REG & (1 << HX711_DT_PIN)) {
+		hx711_pulse();
+		count = count << 1;  // 기존 데이터를 왼쪽으로 1칸 밀어 자리를 만듦
+		if (hal_inputs() & HAL_IN_HX711_DT) {
 			count++; // DT 핀이 HIGH이면 현재 비트는 1이므로 1을 더함
 		}
 	}
 	
 	// 다음 측정을 위한 게인(gain) 값과 채널 설정 펄스 (채널 A, 128배 증폭)
-	HX711_SCK_PORT |= (1 << HX711_SCK_PIN);
-	_delay_us(1);
-	HX711_SCK_PORT &= ~(1 << HX711_SCK_PIN);
-	_delay_us(1);
-	
-	sei(); // 인터럽트 다시 허용
+	hx711_pulse();
 	
 	// HX711의 데이터는 2의 보수 형태이므로, 최상위 비트(24번째)가 1이면 음수임
-	// 이 경우 32비트 long 자료형에 맞게 음수로 변환해줌
+	// 이 경우 음수로 변환해줌 (long 크기와 무관하게 2^24를 뺌)
 	if (count & 0x800000) {
-		count |= 0xFF000000;
+		count -= 0x1000000L;
 	}
 	return count;
 }
 
 long loadcell_get_raw_value(void) {
-	return loadcell_read_raw();
+	return g_latest_raw;
+}
+
+void loadcell_on_data_ready(void) {
+	if (!g_sampling) {
+		return;
+	}
+
+	// 읽기가 끝날 때까지 DT의 비트 변화로 다시 깨지 않도록 DT 인터럽트를 끔
+	hal_hx711_irq(0);
+	g_data_ready = true;
+}
+
+void loadcell_poll(void) {
+	if (!g_data_ready) {
+		return;
+	}
+
+	long raw = hx711_shift_in();
+
+	// 다음 변환 완료(DT 하강)를 다시 기다림
+	HAL_ATOMIC_BLOCK {
+		g_data_ready = false;
+		if (g_sampling) hal_hx711_irq(1);
+	}
+
+	g_latest_raw = raw;
+
+	// 1단계: 이동 중앙값으로 순간적인 튐(spike) 제거
+	long median = loadcell_median_update(raw);
+
+	// 2단계: 1차 IIR 저역 통과 (y += (x - y) / 2^n)
+	g_iir_acc += median - (g_iir_acc >> LOADCELL_IIR_SHIFT);
+	long filtered = g_iir_acc >> LOADCELL_IIR_SHIFT;
+	g_filtered_raw = filtered;
+
+	// 3단계: 히스테리시스 과적 판정 (진입과 해제 기준을 다르게 하여 경계 부근 떨림 방지)
+	if (g_overload) {
+		if (filtered < g_exit_raw) g_overload = false;
+	} else {
+		if (filtered > g_enter_raw) g_overload = true;
+	}
+}
+
+// 필터 상태를 주어진 raw 값으로 채움
+static void loadcell_filter_reset(long raw) {
+	for (uint8_t i = 0; i < LOADCELL_MEDIAN_SIZE; i++) {
+		g_window[i] = raw;
+		g_sorted[i] = raw;
+	}
+	g_window_head = 0;
+	g_iir_acc = raw << LOADCELL_IIR_SHIFT;
+	g_filtered_raw = raw;
+	g_latest_raw = raw;
+	g_overload = false;
+}
+
+// 새 값을 창에 넣고 가장 오래된 값을 빼면서 정렬 배열을 갱신한 뒤 중앙값을 반환
+// 창 크기가 고정(5)이므로 전체 정렬 없이 샘플당 일정한 시간(삭제 1회 + 삽입 1회)에 끝남
+static long loadcell_median_update(long raw) {
+	long oldest = g_window[g_window_head];
+	g_window[g_window_head] = raw;
+	if (++g_window_head >= LOADCELL_MEDIAN_SIZE) g_window_head = 0;
+
+	// 정렬 배열에서 가장 오래된 값의 위치를 찾음
+	uint8_t i = 0;
+	while (g_sorted[i] != oldest) i++;
+
+	// 그 자리에서 새 값이 들어갈 위치까지 원소를 밀며 삽입 (삽입 정렬 한 단계)
+	while (i > 0 && g_sorted[i - 1] > raw) {
+		g_sorted[i] = g_sorted[i - 1];
+		i--;
+	}
+	while (i < LOADCELL_MEDIAN_SIZE - 1 && g_sorted[i + 1] < raw) {
+		g_sorted[i] = g_sorted[i + 1];
+		i++;
+	}
+	g_sorted[i] = raw;
+
+	return g_sorted[LOADCELL_MEDIAN_SIZE / 2];
 }
\ No newline at end of file
@@ -1,22 +1,67 @@
 #include "ic165.h"
 
-uint16_t ic165_read()
+// 세로 카운터(vertical counter) 디바운서: 바이트마다 8개 스위치의 2비트 카운터를 비트 단위로 병렬 운용
+// 스위치마다 (cnt1, cnt0)의 같은 비트가 하나의 카운터이며, 상태와 다른 샘플이 4회 연속되면 상태 반전
+// 체인 길이만큼 바이트 배열로 두므로 스위치가 늘어도 바이트당 같은 비용
+static uint8_t key_state[IC165_CHAIN_BYTES];   // 디바운스된 상태 (1 = 눌림)
+static uint8_t key_cnt0[IC165_CHAIN_BYTES] = {[0 ... IC165_CHAIN_BYTES - 1] = 0xFF};
+static uint8_t key_cnt1[IC165_CHAIN_BYTES] = {[0 ... IC165_CHAIN_BYTES - 1] = 0xFF};
+static uint8_t key_press[IC165_CHAIN_BYTES];   // 눌림 에지 누적
+static uint8_t key_release[IC165_CHAIN_BYTES]; // 떼어짐 에지 누적
+
+// 바이트 i에서 실제로 연결된 스위치 비트 (체인 끝의 빈 입력은 무시)
+#define SW_BITS ((uint8_t)SW_COUNT)
+#define SW_BYTE_MASK(i) (((i) + 1) * 8 <= SW_BITS ? 0xFF : \
+                         (i) * 8 >= SW_BITS ? 0 : (uint8_t)((1 << (SW_BITS - (i) * 8)) - 1))
+
+// 샘플은 ic595_exchange()가 595 출력 래치와 같은 SPI 버스트로 읽어 옴
+void ic165_scan(const uint8_t *sample)
 {
-  uint16_t data = 0;
+  for (uint8_t i = 0; i < IC165_CHAIN_BYTES; i++)
+  {
+    uint8_t changed = key_state[i] ^ (~sample[i] & SW_BYTE_MASK(i)); // Active Low -> 1 = 눌림
+
+    // 상태와 같은 비트는 카운터 리셋(11), 다른 비트는 한 칸씩 감소
+    key_cnt0[i] = ~(key_cnt0[i] & changed);
+    key_cnt1[i] = key_cnt0[i] ^ (key_cnt1[i] & changed);
 
-  CP_LATCH_165_PORT &= ~(1 << CP_LATCH_165_PIN); // Load LOW
-  _delay_us(5);
-  CP_LATCH_165_PORT |= (1 << CP_LATCH_165_PIN); // Load HIGH (데이터 캡처)
+    // 카운터가 한 바퀴 돈(4회 연속 다른) 비트만 상태 반전
+    changed &= key_cnt0[i] & key_cnt1[i];
+    key_state[i] ^= changed;
 
-  for (uint8_t i = 0; i < 16; i++)
+    key_press[i] |= key_state[i] & changed;
+    key_release[i] |= ~key_state[i] & changed;
+  }
+}
+
+void ic165_state(uint8_t *state)
+{
+  for (uint8_t i = 0; i < IC165_CHAIN_BYTES; i++)
+  {
+    state[i] = key_state[i];
+  }
+}
+
+uint8_t ic165_get_press(uint8_t *press)
+{
+  uint8_t any = 0;
+  for (uint8_t i = 0; i < IC165_CHAIN_BYTES; i++)
+  {
+    press[i] = key_press[i];
+    any |= key_press[i];
+    key_press[i] = 0;
+  }
+  return any != 0;
+}
+
+uint8_t ic165_get_release(uint8_t *release)
+{
+  uint8_t any = 0;
+  for (uint8_t i = 0; i < IC165_CHAIN_BYTES; i++)
   {
-    data <<= 1;
-    if (MISO_165_PIN_REG & (1 << MISO_165_PIN))
-    {
-      data |= 1;
-    }
-    SRCLK_PORT |= (1 << SRCLK_PIN);
-    SRCLK_PORT &= ~(1 << SRCLK_PIN);
+    release[i] = key_release[i];
+    any |= key_release[i];
+    key_release[i] = 0;
   }
-  return data;
-}
\ No newline at end of file
+  return any != 0;
+}
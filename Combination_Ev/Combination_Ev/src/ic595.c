@@ -1,52 +1,96 @@
 #include "ic595.h"
+#include "ic165.h"
 
-volatile static uint32_t output_buf = 0xffffffff;
+// 출력 버퍼 (bit n = output_buf[n / 8]의 n % 8, 1 = 켜짐) - 전송할 때 Active Low로 반전
+static uint8_t output_buf[IC595_CHAIN_BYTES];
+static volatile uint8_t output_dirty = 1; // 마지막 래치 이후 바뀐 출력이 있음 (첫 update는 항상 전송)
 
+// 595와 165는 SCK를 공유하므로 한 버스트가 긴 쪽 체인 길이만큼 클럭을 보냄
+#define EXCHANGE_BYTES (IC595_CHAIN_BYTES > IC165_CHAIN_BYTES ? IC595_CHAIN_BYTES : IC165_CHAIN_BYTES)
+
+// 변경된 출력이 있을 때만 전송
+// ISR의 ic595_ledset()은 output_buf만 바꾸고, 메인 루프가 틱마다 한 번 호출해 일괄 반영
+// 데이지 체인은 중간 바이트만 골라 래치할 수 없으므로, 바뀐 바이트가 하나라도 있으면 체인 전체를 보냄
 void ic595_update()
 {
-  RCLK_595_PORT &= ~(1 << RCLK_595_PIN); // Latch LOW
+  if (!output_dirty) return;
+  ic595_exchange(NULL);
+}
+
+// 출력 래치와 74HC165 입력 읽기를 한 번의 SPI 버스트로 수행 (바이트당 약 1us)
+// 수신된 첫 IC165_CHAIN_BYTES 바이트가 165 체인의 스위치 상태 (체인 끝 바이트가 먼저 나옴)
+// 165만 읽을 때도 출력은 같은 값으로 다시 래치되므로 깜빡임 없음
+// SPI는 메인 루프만 쓰므로 출력 버퍼 복사만 인터럽트를 막고, 전송 중에는 인터럽트를 받음
+// (복사 뒤 ISR이 바꾼 출력은 output_dirty로 남아 다음 update에서 전송)
+void ic595_exchange(uint8_t *input)
+{
+  uint8_t out_buf[IC595_CHAIN_BYTES];
 
-  for (uint8_t i = 0; i < 32; i++)
+  HAL_ATOMIC_BLOCK
   {
-    if (output_buf & (1UL << (31 - i)))
+    for (uint8_t i = 0; i < IC595_CHAIN_BYTES; i++)
     {
-      SER_595_PORT |= (1 << SER_595_PIN);
+      out_buf[i] = output_buf[i];
     }
-    else
+    output_dirty = 0;
+  }
+
+  hal_165_load();    // 165 데이터 캡처
+  hal_595_latch(0);  // Latch LOW
+
+  // 먼저 보낸 바이트가 체인의 가장 끝으로 가도록 마지막 바이트부터 MSB First로 전송
+  // 165 체인이 더 길면 앞쪽 더미 바이트는 595 체인을 빠져나감
+  for (uint8_t i = EXCHANGE_BYTES; i-- > 0;)
+  {
+    uint8_t out = (i < IC595_CHAIN_BYTES) ? ~out_buf[i] : 0xFF;
+    uint8_t in = hal_spi_transfer(out);
+
+    // 165는 마지막 단의 바이트부터 나옴
+    uint8_t k = EXCHANGE_BYTES - 1 - i;
+    if (input && k < IC165_CHAIN_BYTES)
     {
-      SER_595_PORT &= ~(1 << SER_595_PIN);
+      input[IC165_CHAIN_BYTES - 1 - k] = in;
     }
-    SRCLK_PORT |= (1 << SRCLK_PIN);
-    SRCLK_PORT &= ~(1 << SRCLK_PIN);
   }
-  RCLK_595_PORT |= (1 << RCLK_595_PIN); // Latch HIGH
+
+  hal_595_latch(1); // Latch HIGH
 }
 
 void ic595_fndset(uint8_t num)
 {
-  if (num > 9) // Out of bound
-  {
-    output_buf |= (0b1111UL << SEG_A_BIT);
-    return;
-  }
-  else // Set bits after clear
-  {
-    output_buf &= ~(0b1111UL << SEG_A_BIT);
-    output_buf |= ((uint32_t)num << SEG_A_BIT);
-  }
+  // Out of bound -> 4비트 모두 1 (빈 표시)
+  if (num > 9) num = 0b1111;
+
+  // BCD 4비트가 바이트 경계에 걸칠 수 있으므로 비트 단위로 설정
+  ic595_ledset(SEG_A_BIT, !(num & 0b0001));
+  ic595_ledset(SEG_B_BIT, !(num & 0b0010));
+  ic595_ledset(SEG_C_BIT, !(num & 0b0100));
+  ic595_ledset(SEG_D_BIT, !(num & 0b1000));
 }
 
-uint8_t ic595_fndget()
+void ic595_clear()
 {
-  // Return current FND number
-  // Is this function needed??
+  HAL_ATOMIC_BLOCK
+  {
+    for (uint8_t i = 0; i < IC595_CHAIN_BYTES; i++)
+    {
+      if (output_buf[i]) output_dirty = 1;
+      output_buf[i] = 0;
+    }
+  }
 }
 
 void ic595_ledset(uint8_t pos, uint8_t state)
 {
-  // Active-Low structure
-  if (state)
-    output_buf &= ~(1UL << pos);
-  else
-    output_buf |= (1UL << pos);
-}
\ No newline at end of file
+  // Active-Low structure (반전은 전송할 때 수행)
+  // ISR과 메인 루프가 함께 쓰므로 read-modify-write를 원자적으로 수행
+  uint8_t *byte = &output_buf[pos >> 3];
+  uint8_t mask = 1 << (pos & 7);
+
+  HAL_ATOMIC_BLOCK
+  {
+    uint8_t old = *byte;
+    *byte = state ? (old | mask) : (old & ~mask);
+    if (*byte != old) output_dirty = 1; // 실제로 바뀐 경우에만 다음 update에서 전송
+  }
+}
@@ -0,0 +1,244 @@
+/*
+ * link.c - framed, CRC-8 protected inter-car protocol on a shared RS-485 bus
+ * Frames wait in a small queue until this car's TDMA slot comes around.
+ */
+
+#include "link.h"
+
+// 수신 파서 상태
+#define RX_WAIT_SYNC 0
+#define RX_DST 1
+#define RX_SRC 2
+#define RX_TYPE 3
+#define RX_SEQ 4
+#define RX_LEN 5
+#define RX_PAYLOAD 6
+#define RX_CRC 7
+
+// =================================================================================
+// --- 전역 변수 ---
+// =================================================================================
+static link_frame_t tx_queue[LINK_TX_QUEUE_SIZE];
+static uint8_t tx_queue_head = 0;
+static uint8_t tx_queue_count = 0;
+static uint8_t tx_seq = 0;
+static uint8_t tx_drop_count = 0;
+
+static uint8_t rx_state = RX_WAIT_SYNC;
+static uint8_t rx_index = 0;
+static uint8_t rx_crc = 0;
+static uint8_t rx_last_seq[LINK_MAX_CARS];
+static uint8_t rx_seq_valid = 0; // 비트 = 카 번호
+
+// TDMA 주기 기준 시각 (이 시각에 0번 카의 슬롯이 시작)
+static uint16_t cycle_origin = 0;
+static uint8_t sync_src = LINK_MAX_CARS; // 마지막으로 시간을 맞춘 카 (번호가 작을수록 우선)
+static uint16_t sync_ms = 0;
+
+static uint8_t crc_error_count = 0;
+static uint8_t lost_frame_count = 0;
+
+// =================================================================================
+// --- 함수 구현 ---
+// =================================================================================
+
+/**
+ * @brief CRC-8 한 바이트 갱신 (다항식 0x07, MSB First)
+ */
+static uint8_t crc8_update(uint8_t crc, uint8_t data)
+{
+  crc ^= data;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    crc = (crc & 0x80) ? (crc << 1) ^ LINK_CRC_POLY : (crc << 1);
+  }
+  return crc;
+}
+
+uint8_t link_send(uint8_t dst, uint8_t type, const void *payload, uint8_t len)
+{
+  const uint8_t *data = (const uint8_t *)payload;
+
+  if (len > LINK_MAX_PAYLOAD || tx_queue_count >= LINK_TX_QUEUE_SIZE)
+  {
+    tx_drop_count++;
+    return 0;
+  }
+
+  link_frame_t *frame = &tx_queue[(tx_queue_head + tx_queue_count) % LINK_TX_QUEUE_SIZE];
+  frame->dst = dst;
+  frame->src = CAR_ID;
+  frame->type = type;
+  frame->seq = tx_seq++;
+  frame->len = len;
+  for (uint8_t i = 0; i < len; i++)
+  {
+    frame->payload[i] = data[i];
+  }
+  tx_queue_count++;
+
+  return 1;
+}
+
+/**
+ * @brief cycle_origin을 현재 주기의 시작까지 주기 단위로 옮깁니다. (1ms마다 호출)
+ * sched_millis()는 65536ms마다 넘어가고 LINK_CYCLE_MS(20)는 65536의 약수가 아니므로
+ * 경과 시간이 넘어가도록 두면 위상이 틀어짐 (기준 카는 link_sync()로 다시 맞추지 않으므로 여기서만 갱신됨)
+ */
+static void link_cycle_advance(void)
+{
+  uint16_t elapsed = sched_millis() - cycle_origin;
+  cycle_origin += elapsed - elapsed % LINK_CYCLE_MS;
+}
+
+/**
+ * @brief 지금이 이 카의 송신 슬롯인지 확인합니다. (슬롯 끝 보호 구간 제외)
+ */
+static uint8_t link_slot_open(void)
+{
+  uint16_t phase = (uint16_t)(sched_millis() - cycle_origin) % LINK_CYCLE_MS;
+  uint16_t slot_start = CAR_ID * LINK_SLOT_MS;
+
+  return phase >= slot_start && phase < slot_start + LINK_SLOT_MS - LINK_SLOT_GUARD_MS;
+}
+
+void link_poll(void)
+{
+  link_cycle_advance();
+
+  // 이전 프레임이 아직 버스에 나가는 중이면 대기
+  if (tx_queue_count == 0 || uart_tx_busy() || !link_slot_open()) return;
+
+  while (tx_queue_count && uart_tx_free() >= tx_queue[tx_queue_head].len + LINK_OVERHEAD)
+  {
+    link_frame_t *frame = &tx_queue[tx_queue_head];
+    uint8_t crc = 0;
+
+    uart_tx_byte(LINK_SYNC);
+
+    uint8_t header[5] = {frame->dst, frame->src, frame->type, frame->seq, frame->len};
+    for (uint8_t i = 0; i < 5; i++)
+    {
+      uart_tx_byte(header[i]);
+      crc = crc8_update(crc, header[i]);
+    }
+
+    for (uint8_t i = 0; i < frame->len; i++)
+    {
+      uart_tx_byte(frame->payload[i]);
+      crc = crc8_update(crc, frame->payload[i]);
+    }
+
+    uart_tx_byte(crc);
+
+    tx_queue_head = (tx_queue_head + 1) % LINK_TX_QUEUE_SIZE;
+    tx_queue_count--;
+  }
+}
+
+/**
+ * @brief 받은 프레임으로 TDMA 주기를 맞춥니다.
+ * 살아 있는 카 중 번호가 가장 작은 카가 기준이 되며, 그 카는 자기 시계를 그대로 씁니다.
+ */
+static void link_sync(uint8_t src)
+{
+  uint16_t now = sched_millis();
+
+  // 기준 카의 프레임이 한동안 없으면 다음으로 작은 번호의 카를 기준으로 삼음
+  if (src > sync_src && (uint16_t)(now - sync_ms) < LINK_PEER_TIMEOUT_MS) return;
+  if (src > CAR_ID) return;
+
+  sync_src = src;
+  sync_ms = now;
+  cycle_origin = now - src * LINK_SLOT_MS; // 슬롯 시작 직후에 보낸 프레임으로 가정
+}
+
+uint8_t link_rx_byte(uint8_t byte, link_frame_t *frame)
+{
+  switch (rx_state)
+  {
+  case RX_WAIT_SYNC:
+    if (byte == LINK_SYNC)
+    {
+      rx_crc = 0;
+      rx_state = RX_DST;
+    }
+    return 0;
+
+  case RX_DST:
+    frame->dst = byte;
+    rx_state = RX_SRC;
+    break;
+
+  case RX_SRC:
+    frame->src = byte;
+    rx_state = RX_TYPE;
+    break;
+
+  case RX_TYPE:
+    frame->type = byte;
+    rx_state = RX_SEQ;
+    break;
+
+  case RX_SEQ:
+    frame->seq = byte;
+    rx_state = RX_LEN;
+    break;
+
+  case RX_LEN:
+    if (byte > LINK_MAX_PAYLOAD)
+    {
+      rx_state = RX_WAIT_SYNC; // 잘못된 길이: 재동기화
+      return 0;
+    }
+    frame->len = byte;
+    rx_index = 0;
+    rx_state = byte ? RX_PAYLOAD : RX_CRC;
+    break;
+
+  case RX_PAYLOAD:
+    frame->payload[rx_index++] = byte;
+    if (rx_index >= frame->len) rx_state = RX_CRC;
+    break;
+
+  case RX_CRC:
+    rx_state = RX_WAIT_SYNC;
+    if (byte != rx_crc)
+    {
+      crc_error_count++;
+      return 0;
+    }
+    if (frame->src >= LINK_MAX_CARS || frame->src == CAR_ID) return 0; // 잘못된 주소 또는 에코
+
+    link_sync(frame->src);
+
+    // 순서 번호가 건너뛰었으면 그 사이 프레임이 손실된 것 (보낸 카별로 확인)
+    uint8_t src_bit = 1 << frame->src;
+    if ((rx_seq_valid & src_bit) && frame->seq != (uint8_t)(rx_last_seq[frame->src] + 1))
+    {
+      lost_frame_count += (uint8_t)(frame->seq - rx_last_seq[frame->src] - 1);
+    }
+    rx_last_seq[frame->src] = frame->seq;
+    rx_seq_valid |= src_bit;
+
+    return (frame->dst == CAR_ID || frame->dst == LINK_BROADCAST);
+  }
+
+  rx_crc = crc8_update(rx_crc, byte);
+  return 0;
+}
+
+uint8_t link_crc_errors(void)
+{
+  return crc_error_count;
+}
+
+uint8_t link_tx_dropped(void)
+{
+  return tx_drop_count;
+}
+
+uint8_t link_lost_frames(void)
+{
+  return lost_frame_count;
+}
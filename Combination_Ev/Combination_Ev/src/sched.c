@@ -0,0 +1,113 @@
+/*
+ * sched.c - 1ms time-triggered cooperative scheduler
+ * The HAL tick timer (Timer0 CTC on AVR) calls sched_tick() every 1ms, which
+ * counts down software timers and wakes the main loop from idle sleep.
+ */
+
+#include "sched.h"
+
+// =================================================================================
+// --- 전역 변수 ---
+// =================================================================================
+static volatile uint16_t tick_ms = 0;                  // 경과 시간 (ms)
+static volatile uint16_t sw_timer[SW_TIMER_COUNT];     // 남은 시간 (ms, 0 = 정지/만료)
+static volatile uint8_t sw_timer_fired = 0;            // 만료 이벤트 비트맵 (비트 = 타이머 ID)
+
+// =================================================================================
+// --- 함수 구현 ---
+// =================================================================================
+
+void sched_init(void)
+{
+  hal_tick_init();
+}
+
+/**
+ * @brief 1ms 시스템 틱. 경과 시간을 올리고 소프트웨어 타이머를 감소시킵니다. (틱 인터럽트에서 호출)
+ */
+void sched_tick(void)
+{
+  tick_ms++;
+
+  for (uint8_t i = 0; i < SW_TIMER_COUNT; i++)
+  {
+    if (sw_timer[i] && --sw_timer[i] == 0)
+    {
+      sw_timer_fired |= (1 << i);
+    }
+  }
+}
+
+uint16_t sched_millis(void)
+{
+  uint16_t now;
+  HAL_ATOMIC_BLOCK
+  {
+    now = tick_ms;
+  }
+  return now;
+}
+
+void sched_dispatch(sched_task_t *tasks, uint8_t count)
+{
+  uint16_t now = sched_millis();
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if ((uint16_t)(now - tasks[i].last_run) >= tasks[i].period_ms)
+    {
+      tasks[i].last_run += tasks[i].period_ms;
+      tasks[i].run();
+    }
+  }
+}
+
+void sched_idle(void)
+{
+  hal_idle();
+}
+
+void timer_start(uint8_t id, uint16_t ms)
+{
+  HAL_ATOMIC_BLOCK
+  {
+    sw_timer[id] = ms;
+    sw_timer_fired &= ~(1 << id);
+  }
+}
+
+void timer_stop(uint8_t id)
+{
+  timer_start(id, 0);
+}
+
+uint8_t timer_running(uint8_t id)
+{
+  uint8_t running;
+  HAL_ATOMIC_BLOCK
+  {
+    running = (sw_timer[id] != 0);
+  }
+  return running;
+}
+
+uint16_t timer_remaining(uint8_t id)
+{
+  uint16_t remaining;
+  HAL_ATOMIC_BLOCK
+  {
+    remaining = sw_timer[id];
+  }
+  return remaining;
+}
+
+uint8_t timer_fired(uint8_t id)
+{
+  uint8_t fired;
+  HAL_ATOMIC_BLOCK
+  {
+    fired = (sw_timer_fired >> id) & 1;
+    sw_timer_fired &= ~(1 << id);
+  }
+  return fired;
+}
@@ -1,6 +1,7 @@
 /*
  * servo.c - ATmega328P Servo Motor Control Library
- * Uses Timer/Counter1 for precise PWM generation.
+ * PWM generation is done by the HAL (Timer/Counter1 Fast PWM on AVR).
+ * Door motion is advanced once per 20ms PWM period from servo_on_period().
  */
 
 #include "servo.h"
@@ -19,41 +20,89 @@
 #define DOOR_CLOSED_ANGLE 0 // 문 닫힘: 0도
 #define DOOR_OPEN_ANGLE 90  // 문 열림: 90도
 
+// 문 이동 속도: PWM 주기(20ms)마다 2도 -> 100도/초 (90도 이동에 약 900ms)
+#define SERVO_DEG_PER_PERIOD 2
+
 // =================================================================================
 // --- 전역 변수 ---
 // =================================================================================
 static volatile uint8_t servo_angle = DOOR_CLOSED_ANGLE;
-extern volatile uint8_t ev_state;
-extern volatile uint32_t state;
+static volatile uint8_t servo_target = DOOR_CLOSED_ANGLE; // 인터럽트 구동 시 목표 각도
+static volatile uint8_t servo_busy = 0;                   // 1: 목표 각도로 이동 중
 
 // =================================================================================
 // --- 함수 구현 ---
 // =================================================================================
 
 /**
- * @brief 서보 모터 초기화. Timer1을 Fast PWM 모드로 설정합니다.
+ * @brief 서보 모터 초기화. 50Hz PWM 출력을 시작합니다.
  */
 void servo_init(void)
 {
-  // 1. PB1(OC1A) 핀을 출력으로 설정
-  SERVO_DDR |= (1 << SERVO_PIN);
+  hal_servo_init();
 
-  // 2. Fast PWM 모드 (TOP=ICR1, Mode 14) 설정
-  TCCR1A |= (1 << WGM11);
-  TCCR1B |= (1 << WGM13) | (1 << WGM12);
+  // 초기 위치를 문 닫힘 상태로 설정
+  servo_set_angle(DOOR_CLOSED_ANGLE);
+  servo_target = DOOR_CLOSED_ANGLE;
+  servo_busy = 0;
+}
 
-  // 3. 비반전 모드 설정 (펄스가 OCR1A 값에 따라 길어짐)
-  TCCR1A |= (1 << COM1A1);
+/**
+ * @brief PWM 주기 인터럽트 (50Hz). 목표 각도를 향해 각도를 한 단계 이동합니다.
+ * 새 펄스폭은 다음 PWM 주기부터 적용됩니다.
+ */
+void servo_on_period(void)
+{
+  uint8_t angle = servo_angle;
 
-  // 4. 주기(Period) 설정 (50Hz -> 20ms)
-  // 16MHz / 8(prescaler) / 40000(ticks) = 50Hz
-  ICR1 = 39999;
+  if (angle < servo_target)
+  {
+    angle = (servo_target - angle > SERVO_DEG_PER_PERIOD) ? angle + SERVO_DEG_PER_PERIOD : servo_target;
+  }
+  else if (angle > servo_target)
+  {
+    angle = (angle - servo_target > SERVO_DEG_PER_PERIOD) ? angle - SERVO_DEG_PER_PERIOD : servo_target;
+  }
+  servo_set_angle(angle);
 
-  // 5. 8분주 프리스케일러로 타이머 시작
-  TCCR1B |= (1 << CS11);
+  if (angle == servo_target)
+  {
+    // 도착: 인터럽트 정지
+    hal_servo_period_irq(0);
+    servo_busy = 0;
+  }
+}
 
-  // 초기 위치를 문 닫힘 상태로 설정
-  servo_set_angle(DOOR_CLOSED_ANGLE);
+/**
+ * @brief 목표 각도로의 이동을 시작합니다. (비차단)
+ * 이동 중에 호출하면 현재 각도에서 새 목표로 방향을 바꿉니다.
+ * @param target_angle 목표 각도 (0 ~ 180도)
+ */
+void servo_move_to(uint8_t target_angle)
+{
+  if (target_angle > 180)
+  {
+    target_angle = 180;
+  }
+
+  hal_servo_period_irq(0);
+  servo_target = target_angle;
+  if (servo_angle == target_angle)
+  {
+    servo_busy = 0;
+    return;
+  }
+  servo_busy = 1;
+  hal_servo_period_irq(1); // 다음 PWM 주기부터 이동
+}
+
+/**
+ * @brief 문(서보)이 이동 중인지 확인합니다.
+ * @return 1: 이동 중, 0: 정지
+ */
+uint8_t servo_door_busy(void)
+{
+  return servo_busy;
 }
 
 /**
@@ -71,26 +120,23 @@ void servo_set_angle(uint8_t angle)
   // 각도(0-180)를 펄스 폭(500-2500us)으로 선형 변환
   uint16_t pulse_width_us = SERVO_MIN_PULSE + ((uint32_t)angle * (SERVO_MAX_PULSE - SERVO_MIN_PULSE)) / 180;
 
-  // 펄스 폭(us)을 타이머 OCR1A 값으로 변환
-  // 타이머 클럭 = 16MHz / 8 = 2MHz -> 1틱당 0.5us
-  // OCR 값 = 펄스폭(us) / 0.5(us/틱) = 펄스폭 * 2
-  OCR1A = pulse_width_us * 2;
+  hal_servo_pulse(pulse_width_us);
 }
 
 /**
- * @brief 엘리베이터 문을 엽니다.
+ * @brief 엘리베이터 문 열기를 시작합니다. (비차단, servo_door_busy()로 완료 확인)
  */
 void servo_door_open(void)
 {
-  servo_move_smooth(DOOR_OPEN_ANGLE, 10);
+  servo_move_to(DOOR_OPEN_ANGLE);
 }
 
 /**
- * @brief 엘리베이터 문을 닫습니다.
+ * @brief 엘리베이터 문 닫기를 시작합니다. (비차단, servo_door_busy()로 완료 확인)
  */
 void servo_door_close(void)
 {
-  servo_move_smooth(DOOR_CLOSED_ANGLE, 10);
+  servo_move_to(DOOR_CLOSED_ANGLE);
 }
 
 /**
@@ -103,15 +149,6 @@ uint8_t servo_door_is_open(void)
   return (servo_angle > 45) ? 1 : 0;
 }
 
-/**
- * @brief 가변 지연시간을 위한 사용자 정의 지연 함수
- * @param ms 지연시간 (밀리초)
- */
-static void delay_ms_variable(uint16_t ms)
-{
-  while (ms--) _delay_ms(1);
-}
-
 /**
  * @brief 서보 모터를 특정 각도로 부드럽게 이동시킵니다.
  * @param target_angle 목표 각도
@@ -125,6 +162,11 @@ void servo_move_smooth(uint8_t target_angle, uint16_t step_delay)
     target_angle = 180;
   }
 
+  // 인터럽트 구동 중인 이동은 취소
+  hal_servo_period_irq(0);
+  servo_target = target_angle;
+  servo_busy = 0;
+
   // 현재 각도와 목표 각도가 같으면 바로 리턴
   if (servo_angle == target_angle)
   {
@@ -137,20 +179,15 @@ void servo_move_smooth(uint8_t target_angle, uint16_t step_delay)
     for (angle = servo_angle + 1; angle <= target_angle; angle++)
     {
       servo_set_angle(angle);
-      delay_ms_variable(step_delay);
+      hal_delay_ms(step_delay);
     }
   }
   else // Closing
   {
     for (angle = servo_angle - 1; angle >= target_angle && angle <= servo_angle; angle--)
     {
-      if (state == 9)
-      {
-        servo_angle = angle;
-        return;
-      }
       servo_set_angle(angle);
-      delay_ms_variable(step_delay);
+      hal_delay_ms(step_delay);
       if (angle == 0) break; // uint8_t 언더플로우 방지
     }
   }
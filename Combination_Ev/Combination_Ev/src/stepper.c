@@ -1,7 +1,8 @@
 /*
  * stepper.c - ATmega328P Stepper Motor Control Library
  * Controls 28BYJ-48 stepper motor with ULN2003 driver
- * Uses 4-step sequence for smooth operation
+ * Uses half-step sequence at low speed and full-step sequence at cruise speed
+ * Steps are generated in the background from the HAL step timer (Timer2 CTC on AVR).
  */
 
 #include "stepper.h"
@@ -13,18 +14,56 @@
 // 스텝모터 제어 상수
 // 28BYJ-48 실제 측정값: Full Step 모드에서 약 2038 스텝/회전
 #define STEPS_PER_REVOLUTION 2000 // 28BYJ-48: 실제 측정 기준값 (1바퀴 정확히)
-#define STEP_DELAY_MS 5           // 각 스텝 사이의 지연시간 (ms) - 안정적인 동작을 위해 증가
+// 층간 이동 스텝 수(STEPS_PER_FLOOR)와 최상층(FLOOR_COUNT)은 building.h에서 설정
+#define HALF_STEPS_PER_FLOOR (2L * STEPS_PER_FLOOR)
+#define STEP_DELAY_MS 5           // 출발/정지 시 스텝 간격 (ms) - 이보다 빨리 출발하면 탈조
+#define STEP_START_SPS (1000 / STEP_DELAY_MS) // 출발 속도 (200 스텝/초)
+#define STEP_CRUISE_SPS 500                    // 정속 구간 속도 (500 스텝/초, 2ms 간격)
 
-// 스텝 시퀀스 패턴 (Full Step sequence for 28BYJ-48)
-// 각 스텝에서 2개의 코일이 동시에 활성화되어 최대 토크 제공
+// 스텝 타이머 설정 (HAL_STEP_TIMER_HZ)
+// 16MHz / 1024(prescaler) = 15625Hz -> 1틱당 64us
+// 5ms / 64us = 78틱 (4.992ms), 2ms / 64us = 31틱 (1.984ms)
+#define STEP_TIMER_HZ HAL_STEP_TIMER_HZ
+
+// 가감속 프로파일 (사다리꼴, 등가속도)
+// 가속 구간 i번째 스텝의 속도: v(i)^2 = v0^2 + (vc^2 - v0^2) * i / (RAMP_LENGTH - 1)
+// 간격 테이블은 컴파일 시에 계산되어 플래시(PROGMEM)에 저장되므로 ISR은 테이블 조회만 수행합니다.
+#define RAMP_LENGTH 64 // 가속(=감속) 구간 스텝 수
+
+// 정수 제곱근 (뉴턴법, 정속 속도에서 시작해 위에서부터 수렴)
+#define ISQRT_STEP(x, g) (((g) + (x) / (g)) / 2)
+#define ISQRT(x) ISQRT_STEP(x, ISQRT_STEP(x, ISQRT_STEP(x, ISQRT_STEP(x, ISQRT_STEP(x, STEP_CRUISE_SPS)))))
+
+#define RAMP_SPS_SQ(i) ((uint32_t)STEP_START_SPS * STEP_START_SPS + \
+                        ((uint32_t)STEP_CRUISE_SPS * STEP_CRUISE_SPS - (uint32_t)STEP_START_SPS * STEP_START_SPS) * (i) / (RAMP_LENGTH - 1))
+#define RAMP_TICKS(i) ((uint8_t)(STEP_TIMER_HZ / ISQRT(RAMP_SPS_SQ(i))))
+#define RAMP_TICKS_4(i) RAMP_TICKS(i), RAMP_TICKS((i) + 1), RAMP_TICKS((i) + 2), RAMP_TICKS((i) + 3)
+#define RAMP_TICKS_16(i) RAMP_TICKS_4(i), RAMP_TICKS_4((i) + 4), RAMP_TICKS_4((i) + 8), RAMP_TICKS_4((i) + 12)
+#define RAMP_TICKS_64(i) RAMP_TICKS_16(i), RAMP_TICKS_16((i) + 16), RAMP_TICKS_16((i) + 32), RAMP_TICKS_16((i) + 48)
+
+// 가속 구간 스텝 간격 테이블 (스텝 타이머 틱 단위, [0] = 출발 속도, [RAMP_LENGTH - 1] = 정속)
+static const uint8_t ramp_table[RAMP_LENGTH] HAL_PROGMEM = {RAMP_TICKS_64(0)};
+
+// 스텝 시퀀스 패턴 (Half Step sequence for 28BYJ-48)
+// 짝수 인덱스는 2개 코일이 동시에 활성화되는 Full Step 패턴과 같고,
+// 홀수 인덱스는 그 사이의 1개 코일 패턴입니다.
+// Full Step 구동은 짝수 위상에서 인덱스를 2씩 이동하는 것과 같습니다.
 // 방향 수정: 반시계방향 시퀀스로 변경
-static const uint8_t step_sequence[4] = {
+static const uint8_t step_sequence[8] = {
     0b1001, // Step 0: D+A (코일 4,1 활성화)
-    0b0011, // Step 1: C+D (코일 3,4 활성화)
-    0b0110, // Step 2: B+C (코일 2,3 활성화)
-    0b1100  // Step 3: A+B (코일 1,2 활성화)
+    0b0001, // Step 1: A   (코일 1 활성화)
+    0b0011, // Step 2: C+D (코일 3,4 활성화)
+    0b0010, // Step 3: D   (코일 2 활성화)
+    0b0110, // Step 4: B+C (코일 2,3 활성화)
+    0b0100, // Step 5: C   (코일 3 활성화)
+    0b1100, // Step 6: A+B (코일 1,2 활성화)
+    0b1000  // Step 7: B   (코일 4 활성화)
 };
 
+// 이 가감속 인덱스 미만(약 400 스텝/초 미만)에서는 Half Step으로 구동하여
+// 탈조가 잘 일어나는 출발/정지 구간의 토크를 확보합니다.
+#define HALF_STEP_RAMP_LIMIT (RAMP_LENGTH / 2)
+
 // 방향 정의
 #define STEPPER_DIRECTION_CW 1  // 시계방향
 #define STEPPER_DIRECTION_CCW 0 // 반시계방향
@@ -32,8 +71,13 @@ static const uint8_t step_sequence[4] = {
 // =================================================================================
 // --- 전역 변수 ---
 // =================================================================================
-static volatile int32_t current_position = 0; // 현재 위치 (스텝 단위)
-static volatile uint8_t current_step = 0;     // 현재 스텝 패턴 인덱스
+// 위치는 모드 전환과 무관하게 항상 Half Step 단위로 관리합니다. (Full Step 1회 = 2)
+static volatile int32_t current_position = 0; // 현재 위치 (Half Step 단위)
+static volatile int32_t target_position = 0;  // 목표 위치 (Half Step 단위)
+static volatile uint8_t current_step = 0;     // 현재 스텝 패턴 인덱스 (0~7)
+static volatile uint8_t stepper_busy = 0;     // 1: 타이머가 스텝을 생성 중
+static volatile int8_t move_dir = 0;          // 현재 회전 방향 (1: 시계, -1: 반시계, 0: 정지)
+static volatile uint8_t ramp_pos = 0;         // 가감속 진행량 (Half Step 단위, 테이블 인덱스 = ramp_pos / 2)
 
 // =================================================================================
 // --- 함수 구현 ---
@@ -45,21 +89,14 @@ static volatile uint8_t current_step = 0;     // 현재 스텝 패턴 인덱스
  */
 void stepper_init(void)
 {
-  // 스텝모터 제어핀들을 출력으로 설정
-  STEPPER_1_DDR |= (1 << STEPPER_1_PIN);
-  STEPPER_2_DDR |= (1 << STEPPER_2_PIN);
-  STEPPER_3_DDR |= (1 << STEPPER_3_PIN);
-  STEPPER_4_DDR |= (1 << STEPPER_4_PIN);
-
-  // 모든 핀을 LOW로 초기화
-  STEPPER_1_PORT &= ~(1 << STEPPER_1_PIN);
-  STEPPER_2_PORT &= ~(1 << STEPPER_2_PIN);
-  STEPPER_3_PORT &= ~(1 << STEPPER_3_PIN);
-  STEPPER_4_PORT &= ~(1 << STEPPER_4_PIN);
+  // 스텝모터 제어핀 출력(LOW), 스텝 타이머 정지 (인터럽트는 이동 시작 시에만 활성화)
+  hal_stepper_init();
 
   // 초기 위치와 스텝 설정
   current_position = 0;
+  target_position = 0;
   current_step = 0;
+  stepper_busy = 0;
 }
 
 /**
@@ -68,89 +105,198 @@ void stepper_init(void)
  */
 void stepper_step(uint8_t step_pattern)
 {
-  // 각 비트를 해당 핀에 출력
-  if (step_pattern & 0x01)
-  {
-    STEPPER_1_PORT |= (1 << STEPPER_1_PIN);
-  }
-  else
+  hal_stepper_coils(step_pattern);
+}
+
+/**
+ * @brief 스텝 타이머를 정지시킵니다. (코일 출력은 유지)
+ */
+static void step_timer_stop(void)
+{
+  hal_step_timer_stop();
+  stepper_busy = 0;
+  move_dir = 0;
+  ramp_pos = 0;
+}
+
+/**
+ * @brief 스텝 타이머 인터럽트. 목표 위치를 향해 한 스텝씩 이동합니다.
+ * 남은 거리가 감속에 필요한 거리(ramp_pos) 이하가 되면 감속하고,
+ * 그 전까지는 정속 속도에 도달할 때까지 가속합니다.
+ * 저속에서는 Half Step, 고속에서는 Full Step으로 구동하며,
+ * Full Step 전환은 2코일 위상(짝수 인덱스)에서만 일어나므로 위치가 어긋나지 않습니다.
+ */
+void stepper_on_timer(void)
+{
+  int32_t remaining = target_position - current_position;
+
+  if (remaining == 0)
   {
-    STEPPER_1_PORT &= ~(1 << STEPPER_1_PIN);
+    step_timer_stop();
+    return;
   }
 
-  if (step_pattern & 0x02)
+  // 목표가 반대편에 있으면 먼저 감속을 마친 뒤 방향을 바꿈
+  int8_t dir = (remaining > 0) ? 1 : -1;
+  if (move_dir == 0 || ramp_pos == 0)
   {
-    STEPPER_2_PORT |= (1 << STEPPER_2_PIN);
+    move_dir = dir;
   }
-  else
+  remaining *= move_dir; // 진행 방향 기준 남은 거리
+
+  // 구동 모드 결정: 고속 + 짝수 위상 + 2 이상 남았을 때만 Full Step
+  uint8_t increment = 1;
+  if ((ramp_pos >> 1) >= HALF_STEP_RAMP_LIMIT && !(current_step & 1) && remaining >= 2)
   {
-    STEPPER_2_PORT &= ~(1 << STEPPER_2_PIN);
+    increment = 2;
   }
 
-  if (step_pattern & 0x04)
+  if (move_dir > 0)
   {
-    STEPPER_3_PORT |= (1 << STEPPER_3_PIN);
+    // 시계방향: 스텝 시퀀스를 정방향으로
+    current_step = (current_step + increment) & 0x07;
+    current_position += increment;
   }
   else
   {
-    STEPPER_3_PORT &= ~(1 << STEPPER_3_PIN);
+    // 반시계방향: 스텝 시퀀스를 역방향으로
+    current_step = (current_step - increment) & 0x07;
+    current_position -= increment;
   }
 
-  if (step_pattern & 0x08)
+  // 현재 스텝 패턴을 모터에 출력
+  stepper_step(step_sequence[current_step]);
+
+  // 다음 스텝 간격 결정
+  remaining -= increment;
+  if (remaining > ramp_pos && ramp_pos < 2 * (RAMP_LENGTH - 1))
   {
-    STEPPER_4_PORT |= (1 << STEPPER_4_PIN);
+    ramp_pos += increment; // 가속
+    if (ramp_pos > 2 * (RAMP_LENGTH - 1)) ramp_pos = 2 * (RAMP_LENGTH - 1);
   }
-  else
+  else if (remaining <= ramp_pos && ramp_pos > 0)
+  {
+    ramp_pos = (ramp_pos > increment) ? ramp_pos - increment : 0; // 감속
+  }
+
+  // 테이블은 Full Step 간격이므로 Half Step 구간에서는 절반 간격으로 같은 선속도를 유지
+  uint8_t ticks = hal_rom_byte(&ramp_table[ramp_pos >> 1]);
+  if ((ramp_pos >> 1) < HALF_STEP_RAMP_LIMIT)
   {
-    STEPPER_4_PORT &= ~(1 << STEPPER_4_PIN);
+    ticks >>= 1;
   }
+  hal_step_timer_period(ticks);
 }
 
 /**
- * @brief 가변 지연시간을 위한 사용자 정의 지연 함수
- * @param ms 지연시간 (밀리초)
+ * @brief 목표 위치로의 이동을 시작합니다. (비차단)
+ * 실제 스텝은 스텝 타이머 인터럽트에서 생성되며, stepper_is_busy()로 완료를 확인합니다.
+ * @param position 목표 위치 (Full Step 단위, 절대 위치)
  */
-static void delay_ms_variable(uint16_t ms)
+void stepper_move_to(int32_t position)
 {
-  while (ms--)
+  HAL_ATOMIC_BLOCK
   {
-    _delay_ms(1);
+    target_position = position * 2; // Half Step 단위로 변환
+    if (current_position == target_position || stepper_busy)
+    {
+      return; // 이미 도착했거나, 이동 중이면 ISR이 새 목표를 따라감
+    }
+
+    stepper_busy = 1;
+    move_dir = 0;
+    ramp_pos = 0;
+    hal_step_timer_start(hal_rom_byte(&ramp_table[0]) >> 1); // 출발 속도 (Half Step)
   }
 }
 
 /**
- * @brief 지정된 스텝 수만큼 모터를 이동시킵니다.
- * @param steps 이동할 스텝 수 (양수: 시계방향, 음수: 반시계방향)
- * @param direction 방향 (1: 시계방향, 0: 반시계방향)
+ * @brief 이동 중인 목표 위치를 변경합니다.
+ * 새 목표가 진행 방향 앞쪽에 있고 남은 거리가 현재 감속 거리(ramp_pos) 이상이면
+ * 가감속 프로파일을 유지한 채 그대로 따라가고, 아니면 기존 목표를 유지합니다.
+ * @param position 새 목표 위치 (Full Step 단위, 절대 위치)
+ * @return 1: 수락, 0: 거절
  */
-void stepper_move_steps(int16_t steps, uint8_t direction)
+uint8_t stepper_retarget(int32_t position)
 {
-  uint16_t abs_steps = (steps < 0) ? -steps : steps;
-
-  // 방향이 매개변수로 지정된 경우 steps의 부호 무시
-  uint8_t actual_direction = direction;
+  uint8_t accepted = 0;
+  uint8_t idle = 0;
+  int32_t target = position * 2; // Half Step 단위로 변환
 
-  for (uint16_t i = 0; i < abs_steps; i++)
+  HAL_ATOMIC_BLOCK
   {
-    if (actual_direction == STEPPER_DIRECTION_CW)
+    if (!stepper_busy)
+    {
+      idle = 1;
+    }
+    else if (move_dir == 0)
     {
-      // 시계방향: 스텝 시퀀스를 정방향으로
-      current_step = (current_step + 1) % 4;
-      current_position++;
+      // 첫 스텝 전: 방향은 ISR이 새 목표 기준으로 정함
+      target_position = target;
+      accepted = 1;
     }
     else
     {
-      // 반시계방향: 스텝 시퀀스를 역방향으로
-      current_step = (current_step == 0) ? 3 : current_step - 1;
-      current_position--;
+      int32_t remaining = (target - current_position) * move_dir; // 진행 방향 기준 남은 거리
+      if (remaining >= ramp_pos)
+      {
+        target_position = target;
+        accepted = 1;
+      }
     }
+  }
+
+  if (idle)
+  {
+    // 정지 중: 새 이동으로 시작
+    stepper_move_to(position);
+    accepted = 1;
+  }
+  return accepted;
+}
+
+/**
+ * @brief 이동 중인 목표 층을 변경합니다.
+ * @param target_floor 새 목표 층 (1~FLOOR_COUNT)
+ * @return 1: 수락, 0: 거절
+ */
+uint8_t stepper_retarget_floor(uint8_t target_floor)
+{
+  if (target_floor < 1 || target_floor > FLOOR_COUNT) return 0;
 
-    // 현재 스텝 패턴을 모터에 출력
-    stepper_step(step_sequence[current_step]);
+  return stepper_retarget((int32_t)(target_floor - 1) * STEPS_PER_FLOOR);
+}
+
+/**
+ * @brief 모터가 이동 중인지 확인합니다.
+ * @return 1: 이동 중, 0: 정지
+ */
+uint8_t stepper_is_busy(void)
+{
+  return stepper_busy;
+}
+
+/**
+ * @brief 지정된 스텝 수만큼 모터를 이동시킵니다. (이동이 끝날 때까지 대기)
+ * 전역 인터럽트가 활성화되어 있어야 합니다.
+ * @param steps 이동할 스텝 수 (양수: 시계방향, 음수: 반시계방향)
+ * @param direction 방향 (1: 시계방향, 0: 반시계방향)
+ */
+void stepper_move_steps(int16_t steps, uint8_t direction)
+{
+  uint16_t abs_steps = (steps < 0) ? -steps : steps;
 
-    // 다음 스텝까지 대기
-    delay_ms_variable(STEP_DELAY_MS);
+  // 방향이 매개변수로 지정된 경우 steps의 부호 무시
+  if (direction == STEPPER_DIRECTION_CW)
+  {
+    stepper_move_to(stepper_get_position() + abs_steps);
+  }
+  else
+  {
+    stepper_move_to(stepper_get_position() - abs_steps);
   }
+
+  while (stepper_is_busy()) hal_idle(); // 스텝 인터럽트가 깨울 때마다 확인
 }
 
 /**
@@ -186,35 +332,50 @@ void stepper_rotate_full(uint8_t direction)
  */
 void stepper_stop(void)
 {
+  HAL_ATOMIC_BLOCK
+  {
+    step_timer_stop();
+    target_position = current_position; // 진행 중인 이동 취소
+  }
   stepper_step(0x00); // 모든 핀을 LOW로
 }
 
 /**
  * @brief 현재 모터의 위치를 반환합니다.
- * @return 현재 위치 (스텝 단위)
+ * @return 현재 위치 (Full Step 단위, Half Step 위상에서는 내림)
  */
 int32_t stepper_get_position(void)
 {
-  return current_position;
+  int32_t position;
+  HAL_ATOMIC_BLOCK
+  {
+    position = current_position;
+  }
+  return position >> 1;
 }
 
 /**
  * @brief 모터의 위치를 초기화합니다.
+ * 이동 중에도 호출될 수 있으므로 코일 위상(current_step)은 유지합니다.
  */
 void stepper_reset_position(void)
 {
-  current_position = 0;
-  current_step = 0;
+  HAL_ATOMIC_BLOCK
+  {
+    current_position = 0;
+  }
 }
 
 /**
- * @brief 엘리베이터를 특정 층으로 이동시킵니다.
- * @param target_floor 목표 층 (1~4)
- * @param current_floor 현재 층 (1~4)
+ * @brief 엘리베이터를 특정 층으로 이동시킵니다. (비차단)
+ * 1층을 위치 0으로 하는 절대 위치로 이동하므로 누적 오차가 생기지 않습니다.
+ * 도착 여부는 stepper_is_busy()로 확인합니다.
+ * @param target_floor 목표 층 (1~FLOOR_COUNT)
+ * @param current_floor 현재 층 (1~FLOOR_COUNT)
  */
 void stepper_move_to_floor(uint8_t target_floor, uint8_t current_floor)
 {
-  if (target_floor < 1 || target_floor > 4 || current_floor < 1 || current_floor > 4)
+  if (target_floor < 1 || target_floor > FLOOR_COUNT || current_floor < 1 || current_floor > FLOOR_COUNT)
   {
     return; // 잘못된 층 번호
   }
@@ -224,18 +385,62 @@ void stepper_move_to_floor(uint8_t target_floor, uint8_t current_floor)
     return; // 이미 목표 층에 있음
   }
 
-  // 층 간 이동에 필요한 스텝 수 (예: 층당 1024 스텝)
-  const uint16_t steps_per_floor = STEPS_PER_REVOLUTION;
+  stepper_move_to((int32_t)(target_floor - 1) * STEPS_PER_FLOOR);
+}
+
+/**
+ * @brief 위치(Half Step 단위)를 층 번호로 변환합니다. (범위 밖은 1층/최상층으로 제한)
+ */
+static uint8_t position_to_floor(int32_t position)
+{
+  if (position <= 0) return 1;
+
+  int32_t floor = position / HALF_STEPS_PER_FLOOR + 1;
+  return (floor > FLOOR_COUNT) ? FLOOR_COUNT : (uint8_t)floor;
+}
+
+/**
+ * @brief 현재 위치에서 가장 가까운 층을 반환합니다.
+ * 층 경계(층 사이 중간 지점)를 지나는 순간 다음 층으로 바뀌므로 이동 중 층 표시에 사용합니다.
+ * @return 층 (1~FLOOR_COUNT)
+ */
+uint8_t stepper_get_floor(void)
+{
+  int32_t position;
+  HAL_ATOMIC_BLOCK
+  {
+    position = current_position;
+  }
+  return position_to_floor(position + HALF_STEPS_PER_FLOOR / 2);
+}
 
-  uint8_t floor_difference = (target_floor > current_floor) ? (target_floor - current_floor) : (current_floor - target_floor);
-  uint16_t steps_to_move = floor_difference * steps_per_floor;
+/**
+ * @brief 지금 감속을 시작하면 정지할 수 있는 진행 방향의 가장 가까운 층을 반환합니다.
+ * 감속에 필요한 거리는 현재 가감속 진행량(ramp_pos)과 같습니다.
+ * 디스패처는 이 층까지는 정지 여부를 늦게 결정할 수 있습니다.
+ * @return 층 (1~FLOOR_COUNT), 정지 중이면 현재 층
+ */
+uint8_t stepper_next_stop_floor(void)
+{
+  int32_t position;
+  int8_t dir;
+  uint8_t braking;
+  HAL_ATOMIC_BLOCK
+  {
+    position = current_position;
+    dir = move_dir;
+    braking = ramp_pos;
+  }
 
-  if (target_floor > current_floor)
+  if (dir > 0)
   {
-    stepper_move_steps(steps_to_move, STEPPER_DIRECTION_CW);
+    // 정지 가능 지점 이상에 있는 가장 낮은 층 (올림)
+    return position_to_floor(position + braking + HALF_STEPS_PER_FLOOR - 1);
   }
-  else
+  else if (dir < 0)
   {
-    stepper_move_steps(steps_to_move, STEPPER_DIRECTION_CCW);
+    // 정지 가능 지점 이하에 있는 가장 높은 층 (내림)
+    return position_to_floor(position - braking);
   }
+  return stepper_get_floor();
 }
@@ -1,77 +1,130 @@
 #include "uart.h"
 
-extern volatile uint8_t task_queue[5];
-extern volatile uint8_t ev_current_dir;
+// 송수신 링 버퍼
+// TX: 메인 루프가 head에 쓰고 송신 인터럽트(uart_on_tx_ready())가 tail에서 꺼냄
+// RX: 수신 인터럽트가 head에 쓰고 메인 루프가 tail에서 꺼냄
+static volatile uint8_t tx_buf[UART_TX_BUF_SIZE];
+static volatile uint8_t tx_head = 0;
+static volatile uint8_t tx_tail = 0;
+static volatile uint8_t rx_buf[UART_RX_BUF_SIZE];
+static volatile uint8_t rx_head = 0;
+static volatile uint8_t rx_tail = 0;
 
-void uart_init(uint16_t baudrate)
+static volatile uint8_t tx_active = 0; // 1: DE HIGH, 마지막 바이트의 정지 비트까지 나가면 0
+static volatile uint8_t tx_overflow_count = 0;
+static volatile uint8_t rx_overflow_count = 0;
+
+void uart_init(uint32_t baudrate)
+{
+  // 8N1, U2X, RS-485 DE는 수신(버스 해제) 상태로 시작
+  hal_uart_init(baudrate);
+}
+
+uint8_t uart_tx_byte(uint8_t data)
 {
-  // 1x mode
-  UCSR0A &= ~(1 << U2X0);
+  uint8_t next = (tx_head + 1) & (UART_TX_BUF_SIZE - 1);
 
-  // Baud rate 31250bps
-  UBRR0H = 0x00;
-  UBRR0L = 31;
+  // 제어 루프가 멈추지 않도록 가득 차면 기다리지 않고 버림
+  if (next == tx_tail)
+  {
+    tx_overflow_count++;
+    return 0;
+  }
 
-  // 8bit
-  UCSR0C |= 0x06;
+  tx_buf[tx_head] = data;
+  tx_head = next;
+
+  HAL_ATOMIC_BLOCK
+  {
+    // 버스를 잡고 송신 시작 (이미 송신 중이면 그대로)
+    tx_active = 1;
+    hal_rs485_de(1);
+    hal_uart_tx_irq(HAL_UART_TX_IRQ_READY);
+  }
 
-  // transmit enable
-  UCSR0B |= (1 << TXEN0);
+  return 1;
+}
 
-  // receive(interrupt) enable
-  UCSR0B |= (1 << RXEN0) | (1 << RXCIE0);
+uint8_t uart_tx_free(void)
+{
+  return (tx_tail - tx_head - 1) & (UART_TX_BUF_SIZE - 1);
 }
 
-void uart_tx_byte(uint8_t data)
+uint8_t uart_tx_busy(void)
 {
-  while (!(UCSR0A & (1 << UDRE0))); // 송신 준비 완료까지 대기
-  UDR0 = data;
+  return tx_active;
 }
 
-uint8_t uart_rx_byte()
+/**
+ * @brief 송신 데이터 레지스터가 비면 링 버퍼에서 다음 바이트를 보냅니다.
+ */
+void uart_on_tx_ready(void)
 {
-  while (!(UCSR0A & (1 << RXC0))); // 수신 완료까지 대기
-  return UDR0;
+  if (tx_head == tx_tail)
+  {
+    // 보낼 데이터 없음: 마지막 바이트가 다 나가면(TXC) 버스 해제
+    hal_uart_tx_irq(HAL_UART_TX_IRQ_DONE);
+    return;
+  }
+
+  hal_uart_write(tx_buf[tx_tail]);
+  tx_tail = (tx_tail + 1) & (UART_TX_BUF_SIZE - 1);
 }
 
-void uart_tx_data(uint8_t score, uint8_t floor, uint8_t dir, uint8_t assign)
+/**
+ * @brief 시프트 레지스터까지 모두 송신 완료. RS-485 버스를 해제합니다.
+ */
+void uart_on_tx_done(void)
 {
-  uart_tx_byte((floor << UART_FLOOR_BIT) | (dir << UART_DIRECTION_BIT) | (assign << UART_ASSIGN_BIT));
+  hal_uart_tx_irq(HAL_UART_TX_IRQ_OFF);
+  hal_rs485_de(0);
+  tx_active = 0;
 }
 
-void enqueue(uint8_t floor, uint8_t dir)
+/**
+ * @brief 수신 바이트를 링 버퍼에 넣습니다. (처리는 메인 루프에서)
+ */
+void uart_on_rx(uint8_t data, uint8_t overrun)
 {
-  floor <<= UART_FLOOR_BIT;
-  dir <<= UART_DIRECTION_BIT;
+  uint8_t next = (rx_head + 1) & (UART_RX_BUF_SIZE - 1);
 
-  // 진행 방향과 같은 층을 우선적으로 처리하도록 큐에 삽입
-  for (uint8_t i = 0; i < 4; i++)
+  if (overrun)
   {
-    if (task_queue[i])
-    {
-      if ((dir & (1 << 7)) != (ev_current_dir & (1 << 7))) // Opposite
-        continue;
-      else if (dir & (1 << 7)) // Descending
-      {
-        if (floor < (task_queue[i] & (0b11 << 5))) // Under
-          continue;
-      }
-      else // Ascending
-      {
-        if (floor > (task_queue[i] & (0b11 << 5))) // Over
-          continue;
-      }
-    }
-    task_queue[i] = (floor | dir);
-    break;
+    rx_overflow_count++; // 이 바이트 앞에서 하드웨어 오버런 발생
   }
+
+  if (next == rx_tail)
+  {
+    rx_overflow_count++;
+    return;
+  }
+
+  rx_buf[rx_head] = data;
+  rx_head = next;
+}
+
+uint8_t uart_rx_read(uint8_t *data)
+{
+  if (rx_tail == rx_head) return 0;
+
+  *data = rx_buf[rx_tail];
+  rx_tail = (rx_tail + 1) & (UART_RX_BUF_SIZE - 1);
+  return 1;
 }
 
-void dequeue()
+uint8_t uart_rx_byte()
 {
-  task_queue[0] = task_queue[1];
-  task_queue[1] = task_queue[2];
-  task_queue[2] = task_queue[3];
-  task_queue[3] = task_queue[4];
-  task_queue[4] = 0;
-}
\ No newline at end of file
+  uint8_t data;
+  while (!uart_rx_read(&data)) hal_idle(); // 수신 완료까지 대기
+  return data;
+}
+
+uint8_t uart_tx_overflows(void)
+{
+  return tx_overflow_count;
+}
+
+uint8_t uart_rx_overflows(void)
+{
+  return rx_overflow_count;
+}